@@ -1,16 +1,25 @@
 #ifndef AABB_H
 #define AABB_H
 
+#include <array>
+
+#include "concepts.h"
 #include "interval.h"
 #include "ray.h"
 #include "vec3.h"
 
-class AABB {
+template <Arithmetic T>
+class BasicMotionAABB;
+
+template <Arithmetic T>
+class BasicAABB {
+    friend class BasicMotionAABB<T>;
+
     private:
-        IntervalD x_ {};
-        IntervalD y_ {};
-        IntervalD z_ {};
-        constexpr static const double delta { 0.0001 };
+        Interval<T> x_ {};
+        Interval<T> y_ {};
+        Interval<T> z_ {};
+        constexpr static const T delta { T(0.0001) };
 
     void pad_to_minimums() {
         if (x_.size() < delta) x_ = x_.expand(delta);
@@ -18,65 +27,89 @@ class AABB {
         if (z_.size() < delta) z_ = z_.expand(delta);
     }
 
+    // Clip [t_min, t_max] to one slab. The near plane is picked from the
+    // direction's sign so no comparison of the two plane distances is
+    // needed, and the min/max compile to conditional moves.
+    static void clip_slab(
+        const Interval<T>& ax,
+        const BasicRay<T>& r,
+        int axis,
+        T& t_min,
+        T& t_max
+    ) {
+        const auto sign { r.sign(axis) };
+        const auto near { sign ? ax.max() : ax.min() };
+        const auto far { sign ? ax.min() : ax.max() };
+        const auto origin { r.origin()[axis] };
+        const auto dir_inv { r.inv_direction()[axis] };
+
+        const auto t0 { (near - origin) * dir_inv };
+        const auto t1 { (far - origin) * dir_inv };
+
+        t_min = t0 > t_min ? t0 : t_min;
+        t_max = t1 < t_max ? t1 : t_max;
+    }
+
     public:
-        AABB() {}
-        AABB(const IntervalD& _x, const IntervalD& _y, const IntervalD& _z)
-            : x_{_x}, y_{_y}, z_{_z} {
+        BasicAABB() {}
+        BasicAABB(
+            const Interval<T>& _x, const Interval<T>& _y, const Interval<T>& _z
+        ) : x_{_x}, y_{_y}, z_{_z} {
                 pad_to_minimums();
             }
 
-        AABB(const Point3& a, const Point3& b) :
+        BasicAABB(const Vec3<T>& a, const Vec3<T>& b) :
             x_{
                 a.x() <= b.x()
-                ? IntervalD(a.x(), b.x()) : IntervalD(b.x(), a.x())
+                ? Interval<T>(a.x(), b.x()) : Interval<T>(b.x(), a.x())
             },
             y_{
                 a.y() <= b.y()
-                ? IntervalD(a.y(), b.y()) : IntervalD(b.y(), a.y())
+                ? Interval<T>(a.y(), b.y()) : Interval<T>(b.y(), a.y())
             },
             z_{
                 a.z() <= b.z()
-                ? IntervalD(a.z(), b.z()) : IntervalD(b.z(), a.z())
+                ? Interval<T>(a.z(), b.z()) : Interval<T>(b.z(), a.z())
             }
             {}
 
-        AABB(const AABB& a, const AABB& b) :
+        BasicAABB(const BasicAABB& a, const BasicAABB& b) :
             x_{a.x(), b.x()},
             y_{a.y(), b.y()},
             z_{a.z(), b.z()}
             {}
 
-        const IntervalD& x() const { return x_; }
-        const IntervalD& y() const { return y_; }
-        const IntervalD& z() const { return z_; }
+        const Interval<T>& x() const { return x_; }
+        const Interval<T>& y() const { return y_; }
+        const Interval<T>& z() const { return z_; }
 
-        const IntervalD& operator[](int i) const {
+        const Interval<T>& operator[](int i) const {
             return (i == 0) ? x_ : (i == 1) ? y_ : z_;
         }
 
-        bool hit(const Ray& r, IntervalD t) const {
-            const auto& ray_origin { r.origin() };
-            const auto& ray_direction { r.direction() };
+        bool hit(const BasicRay<T>& r, Interval<T> t) const {
+            auto t_min { t.min() };
+            auto t_max { t.max() };
 
-            for (int axis = 0; axis < 3; axis++) {
-                const auto& ax { operator[](axis) };
-                const auto dir_inv { 1.0 / ray_direction[axis] };
-
-                const auto t0 { (ax.min() - ray_origin[axis]) * dir_inv };
-                const auto t1 { (ax.max() - ray_origin[axis]) * dir_inv };
-
-                if (t0 < t1) {
-                    if (t0 > t.min()) t = IntervalD{t0, t.max()};
-                    if (t1 < t.max()) t = IntervalD{t.min(), t1};
-                } else {
-                    if (t1 > t.min()) t = IntervalD{t1, t.max()};
-                    if (t0 < t.max()) t = IntervalD{t.min(), t0};
-                }
-
-                if (t.max() <= t.min()) {
-                    return false;
-                }
-            }
+            clip_slab(x_, r, 0, t_min, t_max);
+            clip_slab(y_, r, 1, t_min, t_max);
+            clip_slab(z_, r, 2, t_min, t_max);
+
+            return t_min < t_max;
+        }
+
+        // Narrows t to the part of it inside the box, returning false if
+        // none of it is
+        bool clip(const BasicRay<T>& r, Interval<T>& t) const {
+            auto t_min { t.min() };
+            auto t_max { t.max() };
+
+            clip_slab(x_, r, 0, t_min, t_max);
+            clip_slab(y_, r, 1, t_min, t_max);
+            clip_slab(z_, r, 2, t_min, t_max);
+
+            if (!(t_min < t_max)) return false;
+            t = Interval<T>(t_min, t_max);
             return true;
         }
 
@@ -88,31 +121,102 @@ class AABB {
                     ? 1 : 2;
         }
 
-        static const AABB empty, universe;
+        static const BasicAABB empty, universe;
 };
 
-inline AABB operator+(const AABB& a, const Direction3& b) {
-    return AABB(a.x() + b.x(), a.y() + b.y(), a.z() + b.z());
+template <Arithmetic T>
+inline BasicAABB<T> operator+(const BasicAABB<T>& a, const Vec3<T>& b) {
+    return BasicAABB<T>(a.x() + b.x(), a.y() + b.y(), a.z() + b.z());
 }
 
-inline AABB operator+(const Direction3& b, const AABB& a) {
+template <Arithmetic T>
+inline BasicAABB<T> operator+(const Vec3<T>& b, const BasicAABB<T>& a) {
     return a + b;
 }
 
-inline bool operator==(const AABB& a, const AABB& b) {
+template <Arithmetic T>
+inline bool operator==(const BasicAABB<T>& a, const BasicAABB<T>& b) {
     return a.x() == b.x() && a.y() == b.y() && a.z() == b.z();
 }
 
-inline bool operator!=(const AABB& a, const AABB& b) {
+template <Arithmetic T>
+inline bool operator!=(const BasicAABB<T>& a, const BasicAABB<T>& b) {
     return !(a == b);
 }
 
-const AABB AABB::empty {
-    IntervalD::empty, IntervalD::empty, IntervalD::empty
+template <Arithmetic T>
+const BasicAABB<T> BasicAABB<T>::empty {
+    Interval<T>::empty, Interval<T>::empty, Interval<T>::empty
 };
 
-const AABB AABB::universe {
-    IntervalD::universe, IntervalD::universe, IntervalD::universe
+template <Arithmetic T>
+const BasicAABB<T> BasicAABB<T>::universe {
+    Interval<T>::universe, Interval<T>::universe, Interval<T>::universe
+};
+
+using AABB = BasicAABB<Real>;
+
+// Bounds of a moving object as boxes at shutter open (time 0) and close
+// (time 1). Linearly interpolating them by ray time bounds the object at
+// that time, provided it moves along a straight line at constant speed;
+// the union of such boxes keeps the property, so BVH nodes can hold one.
+// The box is kept as its start and the rate of change of each face, so
+// interpolating a face is a single multiply-add.
+template <Arithmetic T>
+class BasicMotionAABB {
+    private:
+        BasicAABB<T> start_ {};
+        std::array<T, 3> min_rate_ {};
+        std::array<T, 3> max_rate_ {};
+
+        Interval<T> slab(int axis, T time) const {
+            return Interval<T>(
+                start_[axis].min() + min_rate_[axis] * time,
+                start_[axis].max() + max_rate_[axis] * time
+            );
+        }
+
+    public:
+        BasicMotionAABB() {}
+        BasicMotionAABB(const BasicAABB<T>& box) : start_ { box } {}
+        BasicMotionAABB(const BasicAABB<T>& start, const BasicAABB<T>& end)
+            : start_ { start } {
+            for (int axis = 0; axis < 3; axis++) {
+                min_rate_[axis] = end[axis].min() - start[axis].min();
+                max_rate_[axis] = end[axis].max() - start[axis].max();
+            }
+        }
+
+        BasicMotionAABB(const BasicMotionAABB& a, const BasicMotionAABB& b)
+            : BasicMotionAABB {
+                BasicAABB<T> { a.start(), b.start() },
+                BasicAABB<T> { a.end(), b.end() }
+            } {}
+
+        const BasicAABB<T>& start() const { return start_; }
+        BasicAABB<T> end() const { return at(1); }
+
+        BasicAABB<T> at(T time) const {
+            return BasicAABB<T> { slab(0, time), slab(1, time), slab(2, time) };
+        }
+
+        // Box over the whole shutter interval
+        BasicAABB<T> swept() const { return BasicAABB<T> { start_, end() }; }
+
+        // Slab test against the box at the ray's time
+        bool hit(const BasicRay<T>& r, Interval<T> t) const {
+            const auto time { r.time() };
+            auto t_min { t.min() };
+            auto t_max { t.max() };
+            for (int axis = 0; axis < 3; axis++) {
+                BasicAABB<T>::clip_slab(
+                    slab(axis, time), r, axis, t_min, t_max
+                );
+            }
+            return t_min < t_max;
+        }
 };
 
+using MotionAABB = BasicMotionAABB<Real>;
+
 #endif
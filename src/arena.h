@@ -0,0 +1,51 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+
+// Bump allocator owning a scene's primitives, materials and textures. Each
+// type gets its own monotonic buffer, so objects of one type are laid out
+// next to each other, and everything is released in one go when the arena
+// is destroyed. Objects are handed out as shared_ptrs (allocated together
+// with their control block) so they mix freely with heap allocated ones,
+// but none of them may outlive the arena.
+class Arena {
+    private:
+        static constexpr std::size_t initial_block_size { 64 * 1024 };
+
+        std::unordered_map<
+            std::type_index,
+            std::unique_ptr<std::pmr::monotonic_buffer_resource>
+        > resources_ {};
+
+        template <typename T>
+        std::pmr::memory_resource* resource() {
+            auto& resource { resources_[typeid(T)] };
+            if (!resource) {
+                resource = std::make_unique<
+                    std::pmr::monotonic_buffer_resource
+                >(initial_block_size);
+            }
+            return resource.get();
+        }
+
+    public:
+        Arena() = default;
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        template <typename T, typename... Args>
+        std::shared_ptr<T> make(Args&&... args) {
+            return std::allocate_shared<T>(
+                std::pmr::polymorphic_allocator<T> { resource<T>() },
+                std::forward<Args>(args)...
+            );
+        }
+};
+
+#endif
@@ -3,21 +3,37 @@
 
 #include <algorithm>
 #include <memory>
+#include <type_traits>
 
 #include "aabb.h"
+#include "arena.h"
 #include "hittable.h"
 #include "hittable_list.h"
 #include "vec3.h"
 
-class BVHNode : public Hittable {
+// Box is AABB for a plain BVH, or MotionAABB for one whose nodes hold
+// bounds at shutter open and close and are tested at each ray's time, so
+// fast moving objects do not bloat every ray's traversal with their swept
+// bounds. The motion variant costs a few more operations per node, so it
+// is only worth it for scenes with a lot of motion blur.
+template <typename Box>
+class BasicBVHNode : public Hittable {
     private:
         std::shared_ptr<Hittable> left {};
         std::shared_ptr<Hittable> right {};
-        AABB bbox {};
+        Box bbox {};
+
+        static Box bounds(const Hittable& object) {
+            if constexpr (std::is_same_v<Box, MotionAABB>) {
+                return object.motion_bounding_box();
+            } else {
+                return object.bounding_box();
+            }
+        }
 
         static bool box_compare(
-            const std::shared_ptr<Hittable> a,
-            const std::shared_ptr<Hittable> b,
+            const std::shared_ptr<Hittable>& a,
+            const std::shared_ptr<Hittable>& b,
             int axis_index
         ) {
             const auto a_axis_interval { a->bounding_box()[axis_index] };
@@ -25,26 +41,44 @@ class BVHNode : public Hittable {
             return a_axis_interval.min() < b_axis_interval.min();
         }
 
+        // Interior nodes go in the arena when there is one
+        static std::shared_ptr<Hittable> make_node(
+            std::vector<std::shared_ptr<Hittable>>& objects,
+            size_t start,
+            size_t end,
+            Arena* arena
+        ) {
+            if (arena) {
+                return arena->make<BasicBVHNode>(objects, start, end, arena);
+            }
+            return std::make_shared<BasicBVHNode>(objects, start, end);
+        }
+
     public:
-        BVHNode() = default;
-        explicit BVHNode(HittableList list)
-            : BVHNode {list.objects, 0, list.objects.size()} {}
-        explicit BVHNode(
-            std::vector<std::shared_ptr<Hittable>> objects,
+        BasicBVHNode() = default;
+        explicit BasicBVHNode(HittableList list)
+            : BasicBVHNode {list.objects, 0, list.objects.size()} {}
+        BasicBVHNode(HittableList list, Arena& arena)
+            : BasicBVHNode {list.objects, 0, list.objects.size(), &arena} {}
+        // Sorts objects[start, end) in place, so every node of the tree
+        // shares the one list rather than copying it
+        explicit BasicBVHNode(
+            std::vector<std::shared_ptr<Hittable>>& objects,
             size_t start,
-            size_t end
+            size_t end,
+            Arena* arena = nullptr
         ) {
-            bbox = AABB::empty;
-            for (const auto& object : objects) {
-                bbox = AABB(bbox, object->bounding_box());
+            auto swept { AABB::empty };
+            for (size_t i = start; i < end; i++) {
+                swept = AABB(swept, objects[i]->bounding_box());
             }
 
-            const int axis { bbox.longest_axis() };
+            const int axis { swept.longest_axis() };
 
             const auto comparator {
                 [&axis](
-                    const std::shared_ptr<Hittable> a,
-                    const std::shared_ptr<Hittable> b
+                    const std::shared_ptr<Hittable>& a,
+                    const std::shared_ptr<Hittable>& b
                 ) -> bool {
                     return box_compare(a, b, axis);
                 }
@@ -65,24 +99,49 @@ class BVHNode : public Hittable {
                 );
 
                 const auto mid { start + object_span / 2 };
-                left = std::make_shared<BVHNode>(objects, start, mid);
-                right = std::make_shared<BVHNode>(objects, mid, end);
+                left = make_node(objects, start, mid, arena);
+                right = make_node(objects, mid, end, arena);
             }
 
-            bbox = AABB { left->bounding_box(), right->bounding_box() };
+            bbox = Box { bounds(*left), bounds(*right) };
         }
 
-        bool hit(const Ray& r, IntervalD t, HitRecord& rec) const override {
+        bool hit(const Ray& r, IntervalR t, HitRecord& rec) const override {
             if (!bbox.hit(r, t)) return false;
 
             const auto hit_left { left->hit(r, t, rec) };
-            const auto rt { IntervalD{t.min(), hit_left ? rec.t : t.max()} };
+            const auto rt { IntervalR{t.min(), hit_left ? rec.t : t.max()} };
             const auto hit_right { right->hit(r, rt, rec) };
 
             return hit_left || hit_right;
         }
 
-        AABB bounding_box() const override { return bbox; }
+        bool occluded(const Ray& r, IntervalR t) const override {
+            if (!bbox.hit(r, t)) return false;
+            return left->occluded(r, t) || right->occluded(r, t);
+        }
+
+        double transmittance(const Ray& r, IntervalR t) const override {
+            if (!bbox.hit(r, t)) return 1.0;
+            const auto transmitted { left->transmittance(r, t) };
+            if (transmitted <= 0) return 0.0;
+            // A leaf of one object holds it on both sides
+            if (right == left) return transmitted;
+            return transmitted * right->transmittance(r, t);
+        }
+
+        AABB bounding_box() const override {
+            if constexpr (std::is_same_v<Box, MotionAABB>) {
+                return bbox.swept();
+            } else {
+                return bbox;
+            }
+        }
+
+        MotionAABB motion_bounding_box() const override { return bbox; }
 };
 
+using BVHNode = BasicBVHNode<AABB>;
+using MotionBVHNode = BasicBVHNode<MotionAABB>;
+
 #endif
@@ -18,19 +18,33 @@
 #include "pixel_sampler.h"
 #include "sampler_types.h"
 #include "image.h"
+#include "integrator.h"
+#include "wavefront.h"
 #include "world.h"
 #include "renderer.h"
 #include "progress.h"
+#include "thread_pool.h"
+#include "camera_path.h"
 
 class Camera {
 private:
     const ImageData image_data;
-    const Sampler sampler;
+    // Non const so the exposure can change between frames
+    Sampler sampler;
     // Containers contain our images, non const to allow the images to be edited
     // during rendering
     Renderers renderers;
     const int max_depth;
     Progress progress;
+    // View parameters kept so the camera can be moved between renders
+    CameraPose pose_;
+    const Direction3 vup;
+    const double vfov;
+    const double defocus_angle;
+    const double focus_dist;
+    // Angle camera ray cones spread by: the angle between neighbouring
+    // pixels' rays, narrowed as the pixel's samples already average over it
+    const double pixel_spread;
 
     void process_pixel(int i, int j, const World& world) {
         auto pixel_sampler { sampler.pixel(i, j) };
@@ -40,7 +54,9 @@ private:
         ) };
 
         for (const auto& Ray : pixel_sampler_ref) {
-            const auto pixel_colour { world.ray_colour(Ray, max_depth) };
+            const auto pixel_colour { world.ray_colour(
+                Ray, max_depth, RayCone { 0, pixel_spread }
+            ) };
             for (auto& renderer : pixel_renderers) {
                 renderer->process_sample(Ray, pixel_colour);
             }
@@ -48,6 +64,65 @@ private:
         }
     }
 
+    // Renders rows [start_row, end_row) in batches of about batch_size
+    // pixels. Each round every pixel of the batch that still wants samples
+    // contributes one camera ray, and the round is traced as one wavefront.
+    void process_rows_wavefront(
+        int start_row, int end_row, const World& world
+    ) {
+        constexpr int batch_size { 1 << 12 };
+        const int batch_rows { std::max(1, batch_size / image_data.width) };
+        WavefrontIntegrator integrator { world, max_depth, pixel_spread };
+
+        for (int row = start_row; row < end_row; row += batch_rows) {
+            const int rows { std::min(batch_rows, end_row - row) };
+            std::vector<std::unique_ptr<PixelSampler>> pixel_samplers {};
+            // Declared after the samplers they refer to, so they are
+            // destroyed (and write their pixels) first
+            std::vector<std::vector<std::unique_ptr<PixelRenderer>>>
+                pixel_renderers {};
+            for (int j = row; j < row + rows; ++j) {
+                for (int i = 0; i < image_data.width; ++i) {
+                    pixel_samplers.push_back(sampler.pixel(i, j));
+                    pixel_renderers.push_back(
+                        renderers.create_pixel_renderers(
+                            i, j, *pixel_samplers.back()
+                        )
+                    );
+                }
+            }
+
+            std::vector<std::size_t> pixels {};
+            std::vector<Ray> rays {};
+            for (bool first_round { true }; ; first_round = false) {
+                pixels.clear();
+                rays.clear();
+                for (std::size_t p = 0; p < pixel_samplers.size(); ++p) {
+                    auto& pixel_sampler { *pixel_samplers[p] };
+                    if (first_round || pixel_sampler.has_next_sample()) {
+                        pixels.push_back(p);
+                        rays.push_back(pixel_sampler.sample());
+                    }
+                }
+                if (pixels.empty()) break;
+
+                const auto& colours { integrator.trace(rays) };
+                for (std::size_t k = 0; k < pixels.size(); ++k) {
+                    for (auto& renderer : pixel_renderers[pixels[k]]) {
+                        renderer->process_sample(rays[k], colours[k]);
+                    }
+                    pixel_samplers[pixels[k]]->add_sample(colours[k]);
+                }
+            }
+
+            pixel_renderers.clear();
+            for (int j = 0; j < rows; ++j) {
+                progress.update();
+            }
+            progress.print();
+        }
+    }
+
 public:
     Camera() = delete;
     Camera(
@@ -78,17 +153,68 @@ public:
         },
         renderers{ image_data, renderer_types },
         max_depth{ max_depth },
-        progress{ image_data.height } {}
+        progress{ image_data.height },
+        pose_{ lookfrom, lookat },
+        vup{ vup },
+        vfov{ vfov },
+        defocus_angle{ defocus_angle },
+        focus_dist{ focus_dist },
+        pixel_spread{
+            2 * std::tan(degrees_to_radians(vfov) / 2) / image_data.height
+                * std::fmax(
+                    1.0 / 8,
+                    1 / std::sqrt(sampler_config.samples_per_pixel)
+                )
+        } {}
+
+    const CameraPose& pose() const { return pose_; }
+
+    // The up direction; turntables orbit about it
+    const Direction3& up() const { return vup; }
+
+    // Moves the camera, keeping its lens and exposure
+    void set_pose(const CameraPose& pose) {
+        pose_ = pose;
+        sampler.set_view(SamplerData {
+            image_data,
+            pose.lookfrom,
+            pose.lookat,
+            vup,
+            vfov,
+            defocus_angle,
+            focus_dist
+        });
+    }
+
+    void set_exposure(const Exposure& exposure) {
+        sampler.set_exposure(exposure);
+    }
 
-    void render(const World& world) {
-        // Parallel rendering
-        const int num_threads {
-            static_cast<int>(std::thread::hardware_concurrency())
+    // Renders one frame. The camera can render again, e.g. the next frame
+    // of an animation, reusing the world as it is.
+    void render(
+        const World& world,
+        ThreadPool& pool,
+        IntegratorType integrator = IntegratorType::Path
+    ) {
+        progress.reset();
+
+        // Parallel rendering, one chunk of rows per worker
+        const int num_threads { pool.size() };
+        const int chunk_size {
+            (image_data.height + num_threads - 1) / num_threads
         };
-        std::vector<std::thread> threads;
 
         auto process_chunk {
-            [&](int start_row, int end_row) {
+            [&](int chunk) {
+                const int start_row { chunk * chunk_size };
+                const int end_row { std::min(
+                    start_row + chunk_size, image_data.height
+                ) };
+                if (integrator == IntegratorType::Wavefront) {
+                    process_rows_wavefront(start_row, end_row, world);
+                    return;
+                }
                 for (int j = start_row; j < end_row; ++j) {
                     for (int i = 0; i < image_data.width; ++i) {
                         process_pixel(i, j, world);
@@ -99,20 +225,7 @@ public:
             }
         };
 
-        const int chunk_size {
-            (image_data.height + num_threads - 1) / num_threads
-        };
-        for (int i = 0; i < num_threads; ++i) {
-            const int start_row { i * chunk_size };
-            const int end_row { std::min(
-                start_row + chunk_size, image_data.height
-            ) };
-            threads.emplace_back(process_chunk, start_row, end_row);
-        }
-
-        for (auto& thread : threads) {
-            thread.join();
-        }
+        pool.run(num_threads, process_chunk);
 
         progress.done();
     }
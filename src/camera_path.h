@@ -0,0 +1,62 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "transform.h"
+#include "vec3.h"
+
+// Where the camera stands and what it looks at
+struct CameraPose {
+    Point3 lookfrom {};
+    Point3 lookat {};
+};
+
+// One pose per line, as the lookfrom then lookat coordinates:
+// "fx fy fz ax ay az". Blank lines and lines starting with '#' are skipped.
+inline std::vector<CameraPose> read_camera_poses(std::istream& in) {
+    std::vector<CameraPose> poses {};
+    std::string line {};
+    for (int line_number = 1; std::getline(in, line); line_number++) {
+        const auto first { line.find_first_not_of(" \t\r") };
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        std::istringstream fields { line };
+        double v[6] {};
+        for (auto& value : v) {
+            if (!(fields >> value)) {
+                throw std::runtime_error(
+                    "Invalid camera pose on line " + std::to_string(line_number)
+                );
+            }
+        }
+        poses.push_back(CameraPose {
+            Point3(v[0], v[1], v[2]), Point3(v[3], v[4], v[5])
+        });
+    }
+    return poses;
+}
+
+// views poses evenly spaced on a full circle about the axis through the
+// pose's lookat, starting from the pose itself
+inline std::vector<CameraPose> turntable(
+    const CameraPose& pose, const Direction3& axis, int views
+) {
+    std::vector<CameraPose> poses {};
+    const auto offset { pose.lookfrom - pose.lookat };
+    for (int view = 0; view < views; view++) {
+        const auto spin {
+            Affine::rotation(axis, 360.0 * view / views)
+        };
+        poses.push_back(CameraPose {
+            pose.lookat + spin.direction(offset), pose.lookat
+        });
+    }
+    return poses;
+}
+
+#endif
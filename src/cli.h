@@ -7,6 +7,7 @@
 #include <optional>
 
 #include "image.h"
+#include "integrator.h"
 
 struct RenderOptions {
     std::optional<int> scene {};
@@ -20,6 +21,17 @@ struct RenderOptions {
     std::optional<std::string> output_file {};
     ImageFormat output_format {ImageFormat::PPM};
     bool output_density {false};
+    IntegratorType integrator {IntegratorType::Path};
+    int frames {1};
+    double shutter_open {0.0};
+    double shutter_close {1.0};
+    std::optional<std::string> camera_poses {};
+    int turntable_views {0};
+    // Texture memory cap in MiB, 0 for no cap
+    int texture_cache {0};
+    // Width of the images procedural textures are baked into, 0 to
+    // evaluate them on every hit
+    int bake_width {0};
 };
 
 namespace CLI {
@@ -55,6 +67,37 @@ namespace CLI {
 << DEFAULT_OPTIONS.tolerance << ")"
 << std::endl
 << "    -d            Output sampling density image. -o must be specified."
+<< std::endl
+<< "  -i <integrator> Integrator (path or wavefront) (default: "
+<< DEFAULT_OPTIONS.integrator << ")"
+<< std::endl
+<< "  -n <frames>     Render an animation of <frames> frames to numbered"
+<< std::endl
+<< "                  files. -o must be specified. (default: "
+<< DEFAULT_OPTIONS.frames << ")"
+<< std::endl
+<< "  -e <open:close> Shutter open and close as fractions of a frame"
+<< " (default: "
+<< DEFAULT_OPTIONS.shutter_open << ":" << DEFAULT_OPTIONS.shutter_close
+<< ")"
+<< std::endl
+<< "  -p <file>       Render from each camera pose listed in <file>, one"
+<< std::endl
+<< "                  \"fx fy fz ax ay az\" (lookfrom, lookat) per line,"
+<< std::endl
+<< "                  to numbered files. -o must be specified."
+<< std::endl
+<< "  -T <views>      Render a turntable of <views> views around the scene's"
+<< std::endl
+<< "                  camera target to numbered files. -o must be specified."
+<< std::endl
+<< "  -m <MiB>        Keep at most <MiB> of texture tiles in memory, paging"
+<< std::endl
+<< "                  the rest from a scratch file (default: no limit)"
+<< std::endl
+<< "  -k <width>      Bake procedural textures of static spheres into"
+<< std::endl
+<< "                  images <width> texels wide (default: off)"
 << std::endl;
     }
 
@@ -106,6 +149,32 @@ namespace CLI {
         return false;
     }
 
+    static bool parse_integrator(const char* str, IntegratorType& integrator) {
+        if (strcmp(str, "path") == 0) {
+            integrator = IntegratorType::Path;
+            return true;
+        } else if (strcmp(str, "wavefront") == 0) {
+            integrator = IntegratorType::Wavefront;
+            return true;
+        }
+        return false;
+    }
+
+    static bool parse_shutter(const char* str, double& open, double& close) {
+        const auto separator { std::strchr(str, ':') };
+        if (!separator) {
+            return false;
+        }
+        const std::string open_str(str, separator);
+        if (
+            !parse_double(open_str.c_str(), open)
+            || !parse_double(separator + 1, close)
+        ) {
+            return false;
+        }
+        return 0 <= open && open <= close && close <= 1;
+    }
+
     void check_next_arg(int i, int argc, char* argv[]) {
         if (i + 1 >= argc) {
             std::cerr << "Error: -" << argv[i] << " requires a value" << std::endl;
@@ -180,6 +249,32 @@ namespace CLI {
         return format;
     }
 
+    static IntegratorType parse_integrator_field(
+        int& i, int argc, char* argv[]
+    ) {
+        check_next_arg(i, argc, argv);
+        IntegratorType integrator {};
+        if (!parse_integrator(argv[++i], integrator)) {
+            std::cerr << "Error: Invalid value for -" << argv[i] << std::endl;
+            usage(argv[0]);
+            exit(1);
+        }
+        return integrator;
+    }
+
+    static void parse_shutter_field(
+        int& i, int argc, char* argv[], RenderOptions& options
+    ) {
+        check_next_arg(i, argc, argv);
+        if (!parse_shutter(
+            argv[++i], options.shutter_open, options.shutter_close
+        )) {
+            std::cerr << "Error: Invalid value for -" << argv[i] << std::endl;
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+
     RenderOptions parse_args(int argc, char* argv[]) {
         RenderOptions options {};
 
@@ -204,6 +299,20 @@ namespace CLI {
                 options.output_file = parse_string_field(i, argc, argv);
             } else if (strcmp(argv[i], "-f") == 0) {
                 options.output_format = parse_image_format_field(i, argc, argv);
+            } else if (strcmp(argv[i], "-i") == 0) {
+                options.integrator = parse_integrator_field(i, argc, argv);
+            } else if (strcmp(argv[i], "-n") == 0) {
+                options.frames = parse_int_field(i, argc, argv);
+            } else if (strcmp(argv[i], "-e") == 0) {
+                parse_shutter_field(i, argc, argv, options);
+            } else if (strcmp(argv[i], "-p") == 0) {
+                options.camera_poses = parse_string_field(i, argc, argv);
+            } else if (strcmp(argv[i], "-T") == 0) {
+                options.turntable_views = parse_int_field(i, argc, argv);
+            } else if (strcmp(argv[i], "-m") == 0) {
+                options.texture_cache = parse_int_field(i, argc, argv);
+            } else if (strcmp(argv[i], "-k") == 0) {
+                options.bake_width = parse_int_field(i, argc, argv);
             } else if (strcmp(argv[i], "-h") == 0) {
                 usage(argv[0]);
                 exit(0);
@@ -216,6 +325,42 @@ namespace CLI {
             }
         }
 
+        if (options.frames < 1) {
+            std::cerr << "Error: Invalid value for -n" << std::endl;
+            usage(argv[0]);
+            exit(1);
+        }
+        if (options.turntable_views < 0) {
+            std::cerr << "Error: Invalid value for -T" << std::endl;
+            usage(argv[0]);
+            exit(1);
+        }
+        if (options.texture_cache < 0) {
+            std::cerr << "Error: Invalid value for -m" << std::endl;
+            usage(argv[0]);
+            exit(1);
+        }
+        if (options.bake_width < 0) {
+            std::cerr << "Error: Invalid value for -k" << std::endl;
+            usage(argv[0]);
+            exit(1);
+        }
+        if (options.camera_poses && options.turntable_views) {
+            std::cerr << "Error: -p and -T are exclusive" << std::endl;
+            usage(argv[0]);
+            exit(1);
+        }
+        const bool batch {
+            options.frames > 1
+            || options.camera_poses
+            || options.turntable_views
+        };
+        if (batch && !options.output_file) {
+            std::cerr << "Error: -n, -p and -T require -o" << std::endl;
+            usage(argv[0]);
+            exit(1);
+        }
+
         return options;
     }
 }
@@ -1,16 +1,35 @@
 #ifndef CONSTANT_MEDIUM_H
 #define CONSTANT_MEDIUM_H
 
-#include "hittable.h"
+#include "medium.h"
 #include "random.h"
 #include "material.h"
 #include "texture.h"
 
-class ConstantMedium : public Hittable {
+class ConstantMedium : public Medium {
 private:
     std::shared_ptr<Hittable> boundary;
     double neg_inv_density;
-    std::shared_ptr<Material> phase_function;
+
+    // Sample a scattering distance along the ray, returning false if the
+    // ray leaves the medium (or t) first
+    bool sample_distance(const Ray& r, IntervalR t, Real& t_hit) const {
+        auto inside { t };
+        if (!boundary->span(r, inside)) return false;
+
+        const auto entry { inside.min() < 0 ? Real(0) : inside.min() };
+
+        const auto ray_length { r.direction().length() };
+        const auto dist_in_boundary { (inside.max() - entry) * ray_length };
+        const auto hit_dist {
+            neg_inv_density * std::log(gen_rand::random_double())
+        };
+
+        if (hit_dist > dist_in_boundary) return false;
+
+        t_hit = entry + hit_dist / ray_length;
+        return true;
+    }
 
 public:
     ConstantMedium() = delete;
@@ -19,9 +38,9 @@ public:
         double density,
         std::shared_ptr<Texture> tex
     )
-        : boundary{ boundary }
+        : Medium{ std::make_shared<Isotropic>(tex) }
+        , boundary{ boundary }
         , neg_inv_density{ -1 / density }
-        , phase_function{ std::make_shared<Isotropic>(tex) }
     {}
 
     ConstantMedium(
@@ -29,49 +48,33 @@ public:
         double density,
         const Colour& albedo
     )
-        : boundary{ boundary }
+        : Medium{ std::make_shared<Isotropic>(albedo) }
+        , boundary{ boundary }
         , neg_inv_density{ -1 / density }
-        , phase_function{ std::make_shared<Isotropic>(albedo) }
     {}
 
     bool hit(
-        const Ray& r, IntervalD t, HitRecord& rec
+        const Ray& r, IntervalR t, HitRecord& rec
     ) const override {
-        HitRecord rec1, rec2;
-
-        if (!boundary->hit(r, IntervalD::universe, rec1))
-            return false;
-        if (!boundary->hit(r, IntervalD{rec1.t+0.0001, infinity_d}, rec2))
-            return false;
-
-        if (rec1.t < t.min()) rec1.t = t.min();
-        if (rec2.t > t.max()) rec2.t = t.max();
-
-        if (rec1.t >= rec2.t) return false;
-
-        if (rec1.t < 0) rec1.t = 0;
-
-        const auto ray_length { r.direction().length() };
-        const auto dist_in_boundary { (rec2.t - rec1.t) * ray_length };
-        const auto hit_dist {
-            neg_inv_density * std::log(gen_rand::random_double())
-        };
-
-        if (hit_dist > dist_in_boundary) return false;
-
-        rec.t = rec1.t + hit_dist / ray_length;
-        rec.p = r.at(rec.t);
-
-        rec.normal = Direction3{1, 0, 0}; // arbitrary
-        rec.front_face = true; // also arbitrary
-        rec.mat = phase_function;
-
+        if (!sample_distance(r, t, rec.t)) return false;
+        rec.object = this;
         return true;
     }
 
+    // Stochastic: the probability of reporting occlusion equals the opacity
+    // of the medium along the ray
+    bool occluded(const Ray& r, IntervalR t) const override {
+        Real t_hit {};
+        return sample_distance(r, t, t_hit);
+    }
+
     AABB bounding_box() const override {
         return boundary->bounding_box();
     }
+
+    MotionAABB motion_bounding_box() const override {
+        return boundary->motion_bounding_box();
+    }
 };
 
 #endif
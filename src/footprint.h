@@ -0,0 +1,82 @@
+#ifndef FOOTPRINT_H
+#define FOOTPRINT_H
+
+#include <cmath>
+
+#include "vec3.h"
+
+// Cone around a ray, standing in for its ray differentials: the width of
+// the cone where the ray starts and how fast it widens per unit distance.
+// Camera rays start as points with a spread of one pixel's angle.
+struct RayCone {
+    double width { 0 };
+    double spread { 0 };
+
+    RayCone at(double distance) const {
+        return RayCone { width + spread * distance, spread };
+    }
+};
+
+// Region of texture space a lookup covers: an ellipse centred on the hit's
+// (u, v) with semi-axes (du_major, dv_major) and (du_minor, dv_minor). The
+// empty footprint asks for a point lookup.
+struct TextureFootprint {
+    double du_major { 0 };
+    double dv_major { 0 };
+    double du_minor { 0 };
+    double dv_minor { 0 };
+
+    bool empty() const {
+        return du_major == 0 && dv_major == 0
+            && du_minor == 0 && dv_minor == 0;
+    }
+
+    // Ellipse cut by a cone of the given width, travelling along direction,
+    // from the surface with unit normal n. The cut is stretched by the angle
+    // of incidence, and mapped to texture space through the derivatives of
+    // the surface point with respect to u and v.
+    static TextureFootprint project(
+        double width,
+        const Direction3& direction,
+        const Direction3& n,
+        const Direction3& dpdu,
+        const Direction3& dpdv
+    ) {
+        if (width <= 0) return TextureFootprint {};
+
+        // Texture coordinates of tangent vectors, by least squares against
+        // the (possibly skewed) derivatives
+        const auto uu { dot(dpdu, dpdu) };
+        const auto uv { dot(dpdu, dpdv) };
+        const auto vv { dot(dpdv, dpdv) };
+        const auto det { uu * vv - uv * uv };
+        if (!(det > 1e-12 * uu * vv)) return TextureFootprint {};
+
+        const auto d { unit_vector(direction) };
+        const auto cos_theta {
+            std::fmax(std::fabs(dot(d, n)), 1.0 / 16)
+        };
+        // The minor axis is the cone's width across the direction of travel,
+        // or any tangent when looking straight down the normal
+        auto minor { cross(n, d) };
+        if (minor.length_squared() < 1e-12) minor = dpdu;
+        minor = unit_vector(minor) * (width / 2);
+        const auto major {
+            unit_vector(cross(minor, n)) * (width / 2 / cos_theta)
+        };
+
+        const auto to_uv { [&](const Direction3& a, double& du, double& dv) {
+            const auto au { dot(dpdu, a) };
+            const auto av { dot(dpdv, a) };
+            du = (vv * au - uv * av) / det;
+            dv = (uu * av - uv * au) / det;
+        } };
+
+        TextureFootprint footprint {};
+        to_uv(major, footprint.du_major, footprint.dv_major);
+        to_uv(minor, footprint.du_minor, footprint.dv_minor);
+        return footprint;
+    }
+};
+
+#endif
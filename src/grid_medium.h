@@ -0,0 +1,278 @@
+#ifndef GRID_MEDIUM_H
+#define GRID_MEDIUM_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "aabb.h"
+#include "material.h"
+#include "medium.h"
+#include "random.h"
+
+// Medium whose density varies over a box. Densities are given on a grid of
+// cells and interpolated trilinearly between cell centres. Scattering
+// distances are sampled by delta tracking, and shadow rays are attenuated
+// by ratio tracking's estimate of the transmittance rather than being
+// blocked outright. Both take tentative steps against a majorant, the
+// highest density within a brick of cells, walking the bricks along the ray
+// so that thin regions are crossed in long steps and empty ones skipped.
+class GridMedium : public Medium {
+    public:
+        // Density at a point, sampled at each cell centre
+        using Density = std::function<double(const Point3& p)>;
+
+        // Cells along each side of a majorant brick
+        static constexpr int brick_size { 8 };
+
+    private:
+        // Below this, ratio tracking plays Russian roulette with the ray
+        static constexpr double roulette_threshold { 0.1 };
+
+        const AABB bounds;
+        const std::array<int, 3> cells;
+        const std::array<int, 3> bricks;
+        // Cells per unit length along each axis
+        std::array<double, 3> scale {};
+        // Cell densities, x varying fastest
+        std::vector<float> density {};
+        std::vector<float> majorant {};
+
+        int cell_index(int x, int y, int z) const {
+            return (z * cells[1] + y) * cells[0] + x;
+        }
+
+        int brick_index(int x, int y, int z) const {
+            return (z * bricks[1] + y) * bricks[0] + x;
+        }
+
+        double density_at(const Point3& p) const {
+            int i0[3] {}, i1[3] {};
+            double f[3] {};
+            for (int a = 0; a < 3; a++) {
+                const auto g { (p[a] - bounds[a].min()) * scale[a] - 0.5 };
+                const auto fl { std::floor(g) };
+                f[a] = g - fl;
+                const auto i { static_cast<int>(fl) };
+                i0[a] = std::clamp(i, 0, cells[a] - 1);
+                i1[a] = std::clamp(i + 1, 0, cells[a] - 1);
+            }
+
+            const auto d { [&](int x, int y, int z) {
+                return static_cast<double>(density[cell_index(x, y, z)]);
+            } };
+            const auto lerp { [](double a, double b, double t) {
+                return a + (b - a) * t;
+            } };
+            const auto y0 { lerp(
+                lerp(d(i0[0], i0[1], i0[2]), d(i1[0], i0[1], i0[2]), f[0]),
+                lerp(d(i0[0], i1[1], i0[2]), d(i1[0], i1[1], i0[2]), f[0]),
+                f[1]
+            ) };
+            const auto y1 { lerp(
+                lerp(d(i0[0], i0[1], i1[2]), d(i1[0], i0[1], i1[2]), f[0]),
+                lerp(d(i0[0], i1[1], i1[2]), d(i1[0], i1[1], i1[2]), f[0]),
+                f[1]
+            ) };
+            return lerp(y0, y1, f[2]);
+        }
+
+        // Interpolation reaches half a cell past a brick, so each majorant
+        // covers the brick's cells and those bordering it
+        void build_majorants() {
+            majorant.assign(bricks[0] * bricks[1] * bricks[2], 0.0f);
+            for (int bz = 0; bz < bricks[2]; bz++) {
+                for (int by = 0; by < bricks[1]; by++) {
+                    for (int bx = 0; bx < bricks[0]; bx++) {
+                        const int b[3] { bx, by, bz };
+                        int lo[3] {}, hi[3] {};
+                        for (int a = 0; a < 3; a++) {
+                            lo[a] = std::max(0, b[a] * brick_size - 1);
+                            hi[a] = std::min(
+                                cells[a] - 1, (b[a] + 1) * brick_size
+                            );
+                        }
+                        auto& m { majorant[brick_index(bx, by, bz)] };
+                        for (int z = lo[2]; z <= hi[2]; z++) {
+                            for (int y = lo[1]; y <= hi[1]; y++) {
+                                const auto* row {
+                                    &density[cell_index(0, y, z)]
+                                };
+                                for (int x = lo[0]; x <= hi[0]; x++) {
+                                    m = std::max(m, row[x]);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Walks the bricks r crosses within t, taking exponentially
+        // distributed steps against each brick's majorant. step(t, ratio)
+        // is called at every tentative collision with the density there
+        // over the majorant, and ends the walk by returning true. Returns
+        // whether the walk was ended.
+        template <typename Step>
+        bool track(const Ray& r, IntervalR t, Step&& step) const {
+            if (!bounds.clip(r, t)) return false;
+
+            const auto length { static_cast<double>(r.direction().length()) };
+            const double t_end { t.max() };
+            double t_now { std::max(Real(0), t.min()) };
+            if (!(t_now < t_end)) return false;
+
+            // The ray in cell coordinates, where it has the same t
+            int brick[3] {}, dir[3] {};
+            double t_next[3] {}, t_delta[3] {};
+            for (int a = 0; a < 3; a++) {
+                const auto o { (r.origin()[a] - bounds[a].min()) * scale[a] };
+                const auto d { r.direction()[a] * scale[a] };
+                const auto at { o + d * t_now };
+                brick[a] = std::clamp(
+                    static_cast<int>(std::floor(at / brick_size)),
+                    0,
+                    bricks[a] - 1
+                );
+                if (d > 0) {
+                    dir[a] = 1;
+                    t_next[a] = ((brick[a] + 1) * brick_size - o) / d;
+                    t_delta[a] = brick_size / d;
+                } else if (d < 0) {
+                    dir[a] = -1;
+                    t_next[a] = (brick[a] * brick_size - o) / d;
+                    t_delta[a] = -brick_size / d;
+                } else {
+                    t_next[a] = std::numeric_limits<double>::infinity();
+                    t_delta[a] = std::numeric_limits<double>::infinity();
+                }
+            }
+
+            while (t_now < t_end) {
+                const auto axis {
+                    t_next[0] < t_next[1]
+                        ? (t_next[0] < t_next[2] ? 0 : 2)
+                        : (t_next[1] < t_next[2] ? 1 : 2)
+                };
+                const auto t_exit { std::min(t_next[axis], t_end) };
+                const auto m { static_cast<double>(
+                    majorant[brick_index(brick[0], brick[1], brick[2])]
+                ) };
+                if (m > 0) {
+                    // Free flight is memoryless, so a step past the brick
+                    // is simply dropped and the next brick starts afresh
+                    for (;;) {
+                        t_now -= std::log(1 - gen_rand::random_double())
+                            / (m * length);
+                        if (t_now >= t_exit) break;
+                        if (step(t_now, density_at(r.at(t_now)) / m)) {
+                            return true;
+                        }
+                    }
+                }
+
+                t_now = t_exit;
+                brick[axis] += dir[axis];
+                if (brick[axis] < 0 || brick[axis] >= bricks[axis]) break;
+                t_next[axis] += t_delta[axis];
+            }
+            return false;
+        }
+
+        // Delta tracking: each tentative collision is real with probability
+        // density over majorant
+        bool sample_distance(const Ray& r, IntervalR t, Real& t_hit) const {
+            return track(r, t, [&t_hit](double t_now, double ratio) {
+                if (gen_rand::random_double() >= ratio) return false;
+                t_hit = static_cast<Real>(t_now);
+                return true;
+            });
+        }
+
+    public:
+        GridMedium() = delete;
+
+        // Densities in cells[0] x cells[1] x cells[2] cells over bounds,
+        // sampled from sample at each cell's centre, scattering as
+        // phase_function does
+        GridMedium(
+            const AABB& bounds,
+            const std::array<int, 3>& cells,
+            const Density& sample,
+            std::shared_ptr<Material> phase_function
+        )
+            : Medium { phase_function }
+            , bounds { bounds }
+            , cells { cells }
+            , bricks {
+                (cells[0] + brick_size - 1) / brick_size,
+                (cells[1] + brick_size - 1) / brick_size,
+                (cells[2] + brick_size - 1) / brick_size
+            }
+        {
+            for (int a = 0; a < 3; a++) {
+                scale[a] = cells[a] / static_cast<double>(bounds[a].size());
+            }
+
+            density.resize(cells[0] * cells[1] * cells[2]);
+            for (int z = 0; z < cells[2]; z++) {
+                for (int y = 0; y < cells[1]; y++) {
+                    for (int x = 0; x < cells[0]; x++) {
+                        const int c[3] { x, y, z };
+                        Point3 centre {};
+                        for (int a = 0; a < 3; a++) {
+                            centre[a] = static_cast<Real>(
+                                bounds[a].min() + (c[a] + 0.5) / scale[a]
+                            );
+                        }
+                        density[cell_index(x, y, z)] = static_cast<float>(
+                            std::max(0.0, sample(centre))
+                        );
+                    }
+                }
+            }
+            build_majorants();
+        }
+
+        bool hit(
+            const Ray& r, IntervalR t, HitRecord& rec
+        ) const override {
+            if (!sample_distance(r, t, rec.t)) return false;
+            rec.object = this;
+            return true;
+        }
+
+        // Stochastic, like ConstantMedium: occlusion is reported with
+        // probability equal to the opacity along the ray
+        bool occluded(const Ray& r, IntervalR t) const override {
+            Real t_hit {};
+            return sample_distance(r, t, t_hit);
+        }
+
+        // Ratio tracking: every tentative collision scales the estimate by
+        // the chance it was null. Once the estimate is small the ray is
+        // dropped half the time, and doubled when it survives.
+        double transmittance(const Ray& r, IntervalR t) const override {
+            auto transmitted { 1.0 };
+            track(r, t, [&transmitted](double, double ratio) {
+                transmitted *= 1 - ratio;
+                if (transmitted < roulette_threshold) {
+                    if (gen_rand::random_double() < 0.5) {
+                        transmitted = 0;
+                        return true;
+                    }
+                    transmitted *= 2;
+                }
+                return false;
+            });
+            return transmitted;
+        }
+
+        AABB bounding_box() const override { return bounds; }
+};
+
+#endif
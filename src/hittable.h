@@ -7,6 +7,7 @@
 #include "vec3.h"
 #include "interval.h"
 #include "aabb.h"
+#include "footprint.h"
 
 struct HitRecord;
 
@@ -14,14 +15,58 @@ class Hittable {
 public:
     virtual ~Hittable() = default;
 
+    // Closest-hit query. Only records t, the primitive hit (rec.object) and
+    // its surface parameters in rec.u and rec.v, leaving rec untouched on a
+    // miss; the rest of the record is filled in by surface_interaction().
     virtual bool hit(
         const Ray& r,
-        IntervalD t,
+        IntervalR t,
         HitRecord& rec
     ) const = 0;
 
+    // Completes a hit recorded by this object with its point, normal,
+    // material and texture coordinates. Run once, for the final closest hit.
+    virtual void surface_interaction(const Ray& r, HitRecord& rec) const {}
+
+    // Closest hit with full shading data
+    bool closest_hit(const Ray& r, IntervalR t, HitRecord& rec) const;
+
+    // Any-hit query: true if the ray hits anything within t. Returns at the
+    // first intersection found and computes no shading data.
+    virtual bool occluded(const Ray& r, IntervalR t) const = 0;
+
+    // Fraction of light carried along r through t. Surfaces are opaque, so
+    // this is 0 or 1; media and the aggregates that may hold them override
+    // it to account for partial attenuation.
+    virtual double transmittance(const Ray& r, IntervalR t) const {
+        return occluded(r, t) ? 0.0 : 1.0;
+    }
+
+    // Narrows t to the part of r inside the object, for objects a ray
+    // enters at most once, returning false if r is not inside it within t.
+    // By default the entry and exit are found with two hit queries; convex
+    // shapes override this to solve for both at once.
+    virtual bool span(const Ray& r, IntervalR& t) const;
+
     virtual AABB bounding_box() const = 0;
 
+    // Bounds at shutter open and close, see MotionAABB. Only objects moving
+    // in a straight line need to override this; the default holds the
+    // swept box at both ends.
+    virtual MotionAABB motion_bounding_box() const { return bounding_box(); }
+
+    // Solid angle density of random() choosing direction from origin
+    virtual double pdf_value(
+        const Point3& origin, const Direction3& direction
+    ) const {
+        return 0.0;
+    }
+
+    // Direction from origin towards a random point on the object
+    virtual Direction3 random(const Point3& origin) const {
+        return Direction3 { 1, 0, 0 };
+    }
+
     static bool is_front_face(
         const Ray& r, const Direction3& outward_normal
     ) {
@@ -39,20 +84,30 @@ class Material;
 
 struct HitRecord {
     Point3 p {};
-    double t {};
+    Real t {};
     bool front_face {};
     Direction3 normal {};
-    std::shared_ptr<Material> mat {};
+    const Material* mat {};
     // Texture coordinates
     double u {};
     double v {};
+    // Primitive responsible for the hit
+    const Hittable* object {};
+    // When object is a transform, what it hit in object space, which its
+    // surface_interaction() completes; null once that is done
+    const Hittable* instanced {};
+    // Derivatives of p with respect to u and v
+    Direction3 dpdu {};
+    Direction3 dpdv {};
+    // Texture space region the ray's cone covers at the hit
+    TextureFootprint footprint {};
 
     HitRecord() = default;
     HitRecord(
         const Ray& r,
         const Point3& p,
         const Direction3& outward_normal,
-        double t
+        Real t
     )
         : p{ p }
         , t{ t }
@@ -64,6 +119,44 @@ struct HitRecord {
         front_face = dot(r.direction(), outward_normal) < 0;
         normal = front_face ? outward_normal : -outward_normal;
     }
+
+    // Footprint of a cone of the given width arriving along r
+    void set_footprint(const Ray& r, double cone_width) {
+        footprint = TextureFootprint::project(
+            cone_width, r.direction(), normal, dpdu, dpdv
+        );
+    }
+
+    // Ray leaving the hit point, from an origin pushed off the surface on
+    // the side it leaves from so that it cannot hit the surface again
+    Ray spawn_ray(const Direction3& direction, Real time) const {
+        const auto side { dot(direction, normal) > 0 ? normal : -normal };
+        return Ray { offset_ray_origin(p, side), direction, time };
+    }
 };
 
+inline bool Hittable::span(const Ray& r, IntervalR& t) const {
+    HitRecord entry {}, exit {};
+    if (!hit(r, IntervalR::universe, entry)) return false;
+    if (!hit(r, IntervalR(entry.t + Real(0.0001), infinity_r), exit)) {
+        return false;
+    }
+
+    const IntervalR inside {
+        entry.t < t.min() ? t.min() : entry.t,
+        exit.t > t.max() ? t.max() : exit.t
+    };
+    if (inside.min() >= inside.max()) return false;
+    t = inside;
+    return true;
+}
+
+inline bool Hittable::closest_hit(
+    const Ray& r, IntervalR t, HitRecord& rec
+) const {
+    if (!hit(r, t, rec)) return false;
+    rec.object->surface_interaction(r, rec);
+    return true;
+}
+
 #endif
@@ -9,6 +9,7 @@
 class HittableList : public Hittable {
 private:
     AABB bbox {};
+    MotionAABB motion_bbox {};
 public:
     std::vector<std::shared_ptr<Hittable>> objects {};
 
@@ -19,30 +20,67 @@ public:
     void add(std::shared_ptr<Hittable> object) {
         objects.push_back(object);
         bbox = AABB { bbox, object->bounding_box() };
+        motion_bbox = MotionAABB {
+            motion_bbox, object->motion_bounding_box()
+        };
     }
 
     bool hit(
         const Ray& r,
-        IntervalD t,
+        IntervalR t,
         HitRecord& rec
     ) const override {
-        HitRecord temp_rec {};
+        // A miss leaves rec alone, so it always holds the closest hit yet
         bool hit_anything { false };
         auto closest_so_far { t.max() };
 
         for (const auto& object : objects) {
-            auto Interval { IntervalD{t.min(), closest_so_far} };
-            if (object->hit(r, Interval, temp_rec)) {
+            auto Interval { IntervalR{t.min(), closest_so_far} };
+            if (object->hit(r, Interval, rec)) {
                 hit_anything = true;
-                closest_so_far = temp_rec.t;
-                rec = temp_rec;
+                closest_so_far = rec.t;
             }
         }
 
         return hit_anything;
     }
 
+    bool occluded(const Ray& r, IntervalR t) const override {
+        for (const auto& object : objects) {
+            if (object->occluded(r, t)) return true;
+        }
+        return false;
+    }
+
+    double transmittance(const Ray& r, IntervalR t) const override {
+        auto transmitted { 1.0 };
+        for (const auto& object : objects) {
+            transmitted *= object->transmittance(r, t);
+            if (transmitted <= 0) break;
+        }
+        return transmitted;
+    }
+
     AABB bounding_box() const override { return bbox; }
+
+    MotionAABB motion_bounding_box() const override { return motion_bbox; }
+
+    double pdf_value(
+        const Point3& origin, const Direction3& direction
+    ) const override {
+        if (objects.empty()) return 0.0;
+
+        auto sum { 0.0 };
+        for (const auto& object : objects) {
+            sum += object->pdf_value(origin, direction);
+        }
+        return sum / objects.size();
+    }
+
+    Direction3 random(const Point3& origin) const override {
+        const auto size { static_cast<int>(objects.size()) };
+        return objects[gen_rand::random_int(0, size - 1)]->random(origin);
+    }
 };
 
 #endif
@@ -0,0 +1,26 @@
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+#include <ostream>
+#include <string>
+
+// How the camera turns samples into radiance: one path at a time to
+// completion, or in batches stage by stage (see wavefront.h)
+enum class IntegratorType {
+    Path,
+    Wavefront
+};
+
+inline std::string to_string(IntegratorType integrator) {
+    switch (integrator) {
+        case IntegratorType::Path: return "path";
+        case IntegratorType::Wavefront: return "wavefront";
+    }
+    return "";
+}
+
+inline std::ostream& operator<<(std::ostream& os, IntegratorType integrator) {
+    return os << to_string(integrator);
+}
+
+#endif
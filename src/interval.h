@@ -88,5 +88,6 @@ const Interval<T> Interval<T>::universe = Interval<T>(
 );
 
 using IntervalD = Interval<double>;
+using IntervalR = Interval<Real>;
 
 #endif
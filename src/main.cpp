@@ -1,13 +1,17 @@
 #include <memory>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <sstream>
 
 #include "scene.h"
 #include "cli.h"
 #include "sampler.h"
 #include "output.h"
 #include "renderer.h"
+#include "texture_cache.h"
+#include "texture_registry.h"
 
 SamplerConfig create_sampler_config(const RenderOptions& options) {
     SamplerConfig config {};
@@ -41,11 +45,48 @@ std::vector<RendererType> create_renderer_config(const RenderOptions& options) {
     return renderer_types;
 }
 
+// Batches of images go to numbered files, <file>.0001.ext and so on
+std::optional<std::string> output_file(
+    const RenderOptions& options, int image, int images
+) {
+    if (!options.output_file || images == 1) {
+        return options.output_file;
+    }
+    std::ostringstream filename {};
+    filename << options.output_file.value() << "."
+        << std::setw(4) << std::setfill('0') << image + 1;
+    return filename.str();
+}
+
+// The poses to render from: those listed in a file, a turntable around the
+// scene's own view, or just that view
+std::vector<CameraPose> camera_poses(
+    const RenderOptions& options, const Camera& camera
+) {
+    if (options.camera_poses) {
+        std::ifstream file { options.camera_poses.value() };
+        if (!file) {
+            throw std::runtime_error(
+                "Failed to open camera poses: " + options.camera_poses.value()
+            );
+        }
+        const auto poses { read_camera_poses(file) };
+        if (poses.empty()) {
+            throw std::runtime_error(
+                "No camera poses in " + options.camera_poses.value()
+            );
+        }
+        return poses;
+    }
+    if (options.turntable_views > 0) {
+        return turntable(camera.pose(), camera.up(), options.turntable_views);
+    }
+    return { camera.pose() };
+}
+
 int main(int argc, char* argv[]) {
     const auto options = CLI::parse_args(argc, argv);
 
-    OutputHandler output_handler { options.output_file, options.output_format };
-
     const auto sampler_config = create_sampler_config(options);
     const auto renderer_types = create_renderer_config(options);
     const auto scene_number = options.scene.value_or(1);
@@ -54,6 +95,16 @@ int main(int argc, char* argv[]) {
 
     std::clog << "Sampler config: " << sampler_config << std::endl;
 
+    std::clog << "Integrator: " << options.integrator << std::endl;
+
+    // Capped before the scene loads its textures, so they never all sit in
+    // memory at once
+    if (options.texture_cache > 0) {
+        TextureCache::global().set_capacity(
+            static_cast<std::size_t>(options.texture_cache) << 20
+        );
+    }
+
     Scene scene {};
 
     switch (scene_number) {
@@ -63,7 +114,8 @@ int main(int argc, char* argv[]) {
         ); break;
     case 2:
         scene = checkered_spheres(
-            sampler_config, renderer_types, options.aspect_ratio, options.image_width
+            sampler_config, renderer_types, options.aspect_ratio, options.image_width,
+            options.bake_width
         ); break;
     case 3:
         scene = earth(
@@ -71,7 +123,8 @@ int main(int argc, char* argv[]) {
         ); break;
     case 4:
         scene = perlin_spheres(
-            sampler_config, renderer_types, options.aspect_ratio, options.image_width
+            sampler_config, renderer_types, options.aspect_ratio, options.image_width,
+            options.bake_width
         ); break;
     case 5:
         scene = quads(
@@ -87,7 +140,8 @@ int main(int argc, char* argv[]) {
         ); break;
     case 8:
         scene = simple_light(
-            sampler_config, renderer_types, options.aspect_ratio, options.image_width
+            sampler_config, renderer_types, options.aspect_ratio, options.image_width,
+            options.bake_width
         ); break;
     case 9:
         scene = cornell_box(
@@ -99,6 +153,15 @@ int main(int argc, char* argv[]) {
         ); break;
     case 11:
         scene = final_scene(
+            sampler_config, renderer_types, options.aspect_ratio, options.image_width,
+            options.bake_width
+        ); break;
+    case 12:
+        scene = instanced_forest(
+            sampler_config, renderer_types, options.aspect_ratio, options.image_width
+        ); break;
+    case 13:
+        scene = cornell_cloud(
             sampler_config, renderer_types, options.aspect_ratio, options.image_width
         ); break;
     default:
@@ -106,9 +169,48 @@ int main(int argc, char* argv[]) {
         exit(1);
     }
 
-    const auto results { scene.render() };
+    std::vector<CameraPose> poses {};
+    try {
+        poses = camera_poses(options, scene.camera());
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        exit(1);
+    }
+
+    // The scene, including its BVHs and textures, is built once and the
+    // worker threads started once; every image of the batch shares them,
+    // only the camera's pose and exposure move on
+    ThreadPool pool {};
+    const int images { static_cast<int>(poses.size()) * options.frames };
+    for (int image = 0; image < images; image++) {
+        const auto view { image / options.frames };
+        const auto frame { image % options.frames };
+        if (images > 1) {
+            std::clog
+                << "Image: " << image + 1 << "/" << images
+                << " (view " << view + 1 << ", frame " << frame + 1 << ")"
+                << std::endl;
+        }
+
+        scene.camera().set_pose(poses[view]);
+        const auto exposure { Exposure::frame(
+            frame, options.frames, options.shutter_open, options.shutter_close
+        ) };
+        const auto results {
+            scene.render(pool, options.integrator, exposure)
+        };
 
-    output_handler.write(results);
+        OutputHandler output_handler {
+            output_file(options, image, images), options.output_format
+        };
+        output_handler.write(results);
+    }
+
+    // Image files and baked textures both keep their tiles in the cache
+    const auto textures { TextureRegistry::global().stats() };
+    if (textures.cache.peak > 0) {
+        std::clog << "Textures: " << textures << std::endl;
+    }
 
     return 0;
 }
@@ -5,31 +5,77 @@
 
 #include "colour.h"
 #include "hittable.h"
+#include "onb.h"
 #include "texture.h"
 
+// Result of sampling a material. For non-specular lobes attenuation is the
+// sample weight (BSDF * cosine / pdf); specular lobes are delta distributions
+// and carry no meaningful pdf, so they cannot be combined with light sampling.
+struct ScatterRecord {
+    Colour attenuation {};
+    Ray scattered {};
+    double pdf {};
+    bool is_specular {};
+};
+
+// Concrete material families. Lets integrators batch shading work by type
+// and call the final classes directly instead of through the vtable.
+enum class MaterialType {
+    Lambertian,
+    Metal,
+    Dielectric,
+    DiffuseLight,
+    Isotropic,
+    Other
+};
+
 class Material {
     public:
         virtual ~Material() = default;
 
-        virtual bool scatter(
+        virtual MaterialType type() const { return MaterialType::Other; }
+
+        // Sample an outgoing direction, returning false if the ray is absorbed
+        virtual bool sample(
             const Ray& r_in,
             const HitRecord& rec,
-            Colour& attenuation,
-            Ray& scattered
+            ScatterRecord& srec
         ) const {
             return false;
         }
 
+        // BSDF times cosine for the given outgoing direction
+        virtual Colour eval(
+            const Ray& r_in,
+            const HitRecord& rec,
+            const Direction3& direction
+        ) const {
+            return Colour(0, 0, 0);
+        }
+
+        // Solid angle density with which sample() chooses the direction
+        virtual double pdf(
+            const Ray& r_in,
+            const HitRecord& rec,
+            const Direction3& direction
+        ) const {
+            return 0;
+        }
+
         virtual Colour emitted(double u, double v, const Point3& p) const {
             return Colour(0, 0, 0);
         }
 };
 
-class Lambertian : public Material {
+class Lambertian final : public Material {
     private:
         std::shared_ptr<Texture> tex;
 
     public:
+        MaterialType type() const override {
+            return MaterialType::Lambertian;
+        }
+
         Lambertian() = delete;
         explicit Lambertian(const Colour& a)
             : tex { std::make_shared<SolidColour>(a) }
@@ -38,48 +84,123 @@ class Lambertian : public Material {
             : tex { tex }
         {}
 
-        bool scatter(
+        bool sample(
             const Ray& r_in,
             const HitRecord& rec,
-            Colour& attenuation,
-            Ray& scattered
+            ScatterRecord& srec
         ) const override {
-            auto scatter_direction { rec.normal + random_unit_vector() };
-            if (scatter_direction.near_zero()) {
-                scatter_direction = rec.normal;
-            }
-            scattered = Ray { rec.p, scatter_direction, r_in.time() };
-            attenuation = tex->value(rec.u, rec.v, rec.p);
+            const ONB uvw { rec.normal };
+            const auto direction { uvw.transform(random_cosine_direction()) };
+            srec.scattered = rec.spawn_ray(direction, r_in.time());
+            srec.pdf = pdf(r_in, rec, direction);
+            if (srec.pdf <= 0) return false;
+            srec.attenuation = tex->value(rec.u, rec.v, rec.p, rec.footprint);
+            srec.is_specular = false;
             return true;
         }
+
+        Colour eval(
+            const Ray& r_in,
+            const HitRecord& rec,
+            const Direction3& direction
+        ) const override {
+            return tex->value(rec.u, rec.v, rec.p, rec.footprint)
+                * pdf(r_in, rec, direction);
+        }
+
+        double pdf(
+            const Ray& r_in,
+            const HitRecord& rec,
+            const Direction3& direction
+        ) const override {
+            const auto cosine { dot(rec.normal, unit_vector(direction)) };
+            return cosine > 0 ? cosine / pi : 0;
+        }
 };
 
-class Metal : public Material {
+class Metal final : public Material {
     private:
         Colour albedo;
         double fuzz;
+        // Phong exponent of the glossy lobe, roughly matching the spread of
+        // the reflected direction perturbed by fuzz * random_unit_vector()
+        double exponent;
+
+        static double fuzz_to_exponent(double fuzz) {
+            return std::fmax(0.0, 2 / (fuzz * fuzz) - 2);
+        }
+
+        double lobe_pdf(
+            const Ray& r_in,
+            const HitRecord& rec,
+            const Direction3& direction
+        ) const {
+            const auto reflected {
+                unit_vector(reflect(r_in.direction(), rec.normal))
+            };
+            const auto cosine { dot(reflected, unit_vector(direction)) };
+            if (cosine <= 0) return 0;
+            return (exponent + 1) / (2 * pi) * std::pow(cosine, exponent);
+        }
 
     public:
+        MaterialType type() const override {
+            return MaterialType::Metal;
+        }
+
         Metal() = delete;
-        explicit Metal(const Colour& a, double f) : albedo { a }, fuzz { f } {}
+        explicit Metal(const Colour& a, double f)
+            : albedo { a }
+            , fuzz { f }
+            , exponent { fuzz > 0 ? fuzz_to_exponent(fuzz) : 0 }
+        {}
 
-        bool scatter(
+        bool sample(
             const Ray& r_in,
             const HitRecord& rec,
-            Colour& attenuation,
-            Ray& scattered
+            ScatterRecord& srec
         ) const override {
             const auto reflected { reflect(r_in.direction(), rec.normal) };
-            const auto fuzzed {
-                unit_vector(reflected) + (fuzz * random_unit_vector())
+            srec.attenuation = albedo;
+
+            if (fuzz <= 0) {
+                srec.scattered = rec.spawn_ray(reflected, r_in.time());
+                srec.pdf = 0;
+                srec.is_specular = true;
+                return true;
+            }
+
+            const ONB uvw { reflected };
+            const auto direction {
+                uvw.transform(random_phong_direction(exponent))
             };
-            scattered = Ray { rec.p, fuzzed, r_in.time() };
-            attenuation = albedo;
-            return dot(scattered.direction(), rec.normal) > 0;
+            srec.scattered = rec.spawn_ray(direction, r_in.time());
+            srec.pdf = lobe_pdf(r_in, rec, direction);
+            srec.is_specular = false;
+            return dot(direction, rec.normal) > 0 && srec.pdf > 0;
+        }
+
+        Colour eval(
+            const Ray& r_in,
+            const HitRecord& rec,
+            const Direction3& direction
+        ) const override {
+            if (fuzz <= 0 || dot(direction, rec.normal) <= 0) {
+                return Colour(0, 0, 0);
+            }
+            return albedo * lobe_pdf(r_in, rec, direction);
+        }
+
+        double pdf(
+            const Ray& r_in,
+            const HitRecord& rec,
+            const Direction3& direction
+        ) const override {
+            return fuzz > 0 ? lobe_pdf(r_in, rec, direction) : 0;
         }
 };
 
-class Dielectric : public Material {
+class Dielectric final : public Material {
     private:
         double ir;
 
@@ -91,18 +212,23 @@ class Dielectric : public Material {
         }
 
     public:
+        MaterialType type() const override {
+            return MaterialType::Dielectric;
+        }
+
         Dielectric() = delete;
         explicit Dielectric(double index_of_refraction)
             : ir { index_of_refraction }
         {}
 
-        bool scatter(
+        bool sample(
             const Ray& r_in,
             const HitRecord& rec,
-            Colour& attenuation,
-            Ray& scattered
+            ScatterRecord& srec
         ) const override {
-            attenuation = Colour(1.0, 1.0, 1.0);
+            srec.attenuation = Colour(1.0, 1.0, 1.0);
+            srec.pdf = 0;
+            srec.is_specular = true;
             const auto refraction_ratio {
                 rec.front_face ? (1.0 / ir) : ir
             };
@@ -124,16 +250,20 @@ class Dielectric : public Material {
                     : refract(unit_direction, rec.normal, refraction_ratio)
             };
 
-            scattered = Ray { rec.p, direction, r_in.time() };
+            srec.scattered = rec.spawn_ray(direction, r_in.time());
             return true;
         }
 };
 
-class DiffuseLight : public Material {
+class DiffuseLight final : public Material {
     private:
         std::shared_ptr<Texture> tex;
 
     public:
+        MaterialType type() const override {
+            return MaterialType::DiffuseLight;
+        }
+
         DiffuseLight() = delete;
         explicit DiffuseLight(std::shared_ptr<Texture> tex) : tex { tex } {}
         explicit DiffuseLight(const Colour& emit)
@@ -145,27 +275,50 @@ class DiffuseLight : public Material {
         }
 };
 
-class Isotropic : public Material {
+class Isotropic final : public Material {
     private:
         std::shared_ptr<Texture> tex;
 
     public:
+        MaterialType type() const override {
+            return MaterialType::Isotropic;
+        }
+
         Isotropic() = delete;
         explicit Isotropic(const Colour& albedo)
             : tex { std::make_shared<SolidColour>(albedo) }
         {}
         explicit Isotropic(std::shared_ptr<Texture> tex) : tex { tex } {}
 
-        bool scatter(
+        bool sample(
             const Ray& r_in,
             const HitRecord& rec,
-            Colour& attenuation,
-            Ray& scattered
+            ScatterRecord& srec
         ) const override {
-            scattered = Ray { rec.p, random_unit_vector(), r_in.time() };
-            attenuation = tex->value(rec.u, rec.v, rec.p);
+            srec.scattered = rec.spawn_ray(
+                random_unit_vector(), r_in.time()
+            );
+            srec.attenuation = tex->value(rec.u, rec.v, rec.p, rec.footprint);
+            srec.pdf = 1 / (4 * pi);
+            srec.is_specular = false;
             return true;
         }
+
+        Colour eval(
+            const Ray& r_in,
+            const HitRecord& rec,
+            const Direction3& direction
+        ) const override {
+            return tex->value(rec.u, rec.v, rec.p, rec.footprint) / (4 * pi);
+        }
+
+        double pdf(
+            const Ray& r_in,
+            const HitRecord& rec,
+            const Direction3& direction
+        ) const override {
+            return 1 / (4 * pi);
+        }
 };
 
 #endif
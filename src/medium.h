@@ -0,0 +1,30 @@
+#ifndef MEDIUM_H
+#define MEDIUM_H
+
+#include <memory>
+
+#include "hittable.h"
+#include "material.h"
+
+// Participating medium. Its hit() samples a distance at which the ray
+// scatters and records t like any primitive; the scattering event is then
+// completed here, with the medium's phase function as the material.
+class Medium : public Hittable {
+    private:
+        std::shared_ptr<Material> phase_function;
+
+    protected:
+        explicit Medium(std::shared_ptr<Material> phase_function)
+            : phase_function { phase_function } {}
+
+    public:
+        void surface_interaction(const Ray& r, HitRecord& rec) const override {
+            rec.p = r.at(rec.t);
+
+            rec.normal = Direction3{1, 0, 0}; // arbitrary
+            rec.front_face = true; // also arbitrary
+            rec.mat = phase_function.get();
+        }
+};
+
+#endif
@@ -0,0 +1,339 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "colour.h"
+#include "footprint.h"
+#include "rtw_stb_image.h"
+#include "texel.h"
+#include "texture_cache.h"
+
+// Image pyramid for filtered texture lookups. Level 0 is the image itself
+// and each further level halves it with a box filter in linear RGB, down to
+// a single texel. Texels are stored compactly in the image's format, and
+// kept in square tiles in the texture cache so that a lookup touches a few
+// small blocks rather than rows spanning the whole image, and so that the
+// cache can page them out.
+class MipMap {
+    public:
+        // Texels along each side of a tile, a power of two
+        static constexpr int tile_shift { 5 };
+        static constexpr int tile_size { 1 << tile_shift };
+
+    private:
+        // A whole level, row by row, while the pyramid is built
+        struct Texels {
+            int width { 0 };
+            int height { 0 };
+            std::vector<float> texels {};
+
+            std::array<float, 3> texel(int x, int y) const {
+                x = std::clamp(x, 0, width - 1);
+                y = std::clamp(y, 0, height - 1);
+                const auto* p { texels.data() + 3 * (y * width + x) };
+                return { p[0], p[1], p[2] };
+            }
+        };
+
+        // Level 0 of a loaded image, read from its decoded pixels as it is
+        // cut into tiles rather than first copied out as floats
+        struct ImageTexels {
+            const rtw_image& image;
+            int width { 0 };
+            int height { 0 };
+
+            std::array<float, 3> texel(int x, int y) const {
+                return image.linear_pixel_data(
+                    std::clamp(x, 0, width - 1), std::clamp(y, 0, height - 1)
+                );
+            }
+        };
+
+        struct Level {
+            int width { 0 };
+            int height { 0 };
+            int tiles_x { 0 };
+            // While the cache is unbounded its tiles are never evicted, so
+            // the level keeps them and reads them without asking the cache
+            std::vector<TextureCache::TilePtr> pinned {};
+            std::vector<const unsigned char*> texels {};
+        };
+
+        // Most texels a lookup averages along its footprint's major axis
+        static constexpr int max_anisotropy { 8 };
+
+        TextureCache& cache_;
+        const std::uint32_t image_;
+        const bool pinned_;
+        const TexelFormat format_;
+        std::vector<Level> levels_ {};
+
+        template <typename Fine>
+        static Texels downsample(const Fine& fine) {
+            Texels coarse {
+                std::max(1, fine.width / 2), std::max(1, fine.height / 2), {}
+            };
+            coarse.texels.resize(3 * coarse.width * coarse.height);
+            auto* out { coarse.texels.data() };
+            for (int y = 0; y < coarse.height; y++) {
+                for (int x = 0; x < coarse.width; x++) {
+                    const std::array<float, 3> quad[4] {
+                        fine.texel(2 * x, 2 * y),
+                        fine.texel(2 * x + 1, 2 * y),
+                        fine.texel(2 * x, 2 * y + 1),
+                        fine.texel(2 * x + 1, 2 * y + 1)
+                    };
+                    for (int c = 0; c < 3; c++) {
+                        *out++ = 0.25f
+                            * (quad[0][c] + quad[1][c] + quad[2][c] + quad[3][c]);
+                    }
+                }
+            }
+            return coarse;
+        }
+
+        // Cuts a level into tiles for the cache. Tiles on the right and
+        // bottom edges are padded by repeating the edge texels.
+        template <typename Source>
+        void store(const Source& level) {
+            const auto index { static_cast<int>(levels_.size()) };
+            const auto tiles_x { (level.width + tile_size - 1) / tile_size };
+            const auto tiles_y { (level.height + tile_size - 1) / tile_size };
+            levels_.push_back(Level { level.width, level.height, tiles_x });
+
+            for (int ty = 0; ty < tiles_y; ty++) {
+                for (int tx = 0; tx < tiles_x; tx++) {
+                    const auto stride { texel::bytes(format_) };
+                    TextureCache::Tile tile(stride * tile_size * tile_size);
+                    auto* out { tile.data() };
+                    for (int y = 0; y < tile_size; y++) {
+                        for (int x = 0; x < tile_size; x++) {
+                            const auto texel { level.texel(
+                                tx * tile_size + x, ty * tile_size + y
+                            ) };
+                            texel::encode(format_, texel.data(), out);
+                            out += stride;
+                        }
+                    }
+                    auto stored { cache_.insert(
+                        TextureCache::key(image_, index, ty * tiles_x + tx),
+                        std::move(tile)
+                    ) };
+                    if (pinned_) {
+                        levels_.back().texels.push_back(stored->data());
+                        levels_.back().pinned.push_back(std::move(stored));
+                    }
+                }
+            }
+        }
+
+        const unsigned char* tile(const Level& l, int index, int x, int y)
+            const {
+            const auto tile {
+                (y >> tile_shift) * l.tiles_x + (x >> tile_shift)
+            };
+            if (pinned_) return l.texels[tile];
+            return cache_.fetch(TextureCache::key(image_, index, tile));
+        }
+
+        template <TexelFormat F>
+        static const unsigned char* texel(
+            const unsigned char* tile, int x, int y
+        ) {
+            constexpr int mask { tile_size - 1 };
+            return tile
+                + texel::bytes(F) * (((y & mask) << tile_shift) + (x & mask));
+        }
+
+        template <TexelFormat F>
+        std::array<float, 3> texel(const Level& l, int index, int x, int y)
+            const {
+            x = std::clamp(x, 0, l.width - 1);
+            y = std::clamp(y, 0, l.height - 1);
+            return texel::decode<F>(texel<F>(tile(l, index, x, y), x, y));
+        }
+
+        // Bilinear lookup in one level, at texture coordinates (s, t) with
+        // t growing down the image
+        template <TexelFormat F>
+        Colour bilinear(int level, double s, double t) const {
+            const auto& l { levels_[level] };
+            const auto x { s * l.width - 0.5 };
+            const auto y { t * l.height - 0.5 };
+            const auto x0 { static_cast<int>(std::floor(x)) };
+            const auto y0 { static_cast<int>(std::floor(y)) };
+            const auto fx { x - x0 };
+            const auto fy { y - y0 };
+
+            const auto w00 { (1 - fx) * (1 - fy) };
+            const auto w10 { fx * (1 - fy) };
+            const auto w01 { (1 - fx) * fy };
+            const auto w11 { fx * fy };
+            const auto blend { [=](const std::array<float, 3>& p00,
+                                   const std::array<float, 3>& p10,
+                                   const std::array<float, 3>& p01,
+                                   const std::array<float, 3>& p11) {
+                return Colour {
+                    w00 * p00[0] + w10 * p10[0] + w01 * p01[0] + w11 * p11[0],
+                    w00 * p00[1] + w10 * p10[1] + w01 * p01[1] + w11 * p11[1],
+                    w00 * p00[2] + w10 * p10[2] + w01 * p01[2] + w11 * p11[2]
+                };
+            } };
+
+            // Most footprints fall inside one tile, which is then fetched
+            // once for all four texels
+            const auto x1 { x0 + 1 };
+            const auto y1 { y0 + 1 };
+            if (
+                x0 >= 0 && y0 >= 0 && x1 < l.width && y1 < l.height
+                && (x1 & (tile_size - 1)) != 0
+                && (y1 & (tile_size - 1)) != 0
+            ) {
+                constexpr auto stride { texel::bytes(F) };
+                const auto* p00 { texel<F>(tile(l, level, x0, y0), x0, y0) };
+                const auto* p01 { p00 + stride * tile_size };
+                return blend(
+                    texel::decode<F>(p00), texel::decode<F>(p00 + stride),
+                    texel::decode<F>(p01), texel::decode<F>(p01 + stride)
+                );
+            }
+
+            return blend(
+                texel<F>(l, level, x0, y0), texel<F>(l, level, x1, y0),
+                texel<F>(l, level, x0, y1), texel<F>(l, level, x1, y1)
+            );
+        }
+
+        // Bilinear lookups in the two levels around the fractional level
+        template <TexelFormat F>
+        Colour trilinear(double level, double s, double t) const {
+            const auto top { static_cast<double>(levels() - 1) };
+            level = std::clamp(level, 0.0, top);
+            const auto fine { static_cast<int>(std::floor(level)) };
+            const auto blend { level - fine };
+            if (blend == 0) return bilinear<F>(fine, s, t);
+            return (1 - blend) * bilinear<F>(fine, s, t)
+                + blend * bilinear<F>(fine + 1, s, t);
+        }
+
+        template <TexelFormat F>
+        Colour filter(
+            double s, double t, const TextureFootprint& footprint
+        ) const {
+            if (footprint.empty()) return bilinear<F>(0, s, t);
+
+            // Axes in level 0 texels
+            auto major_s { footprint.du_major * width() };
+            // t runs down the image, against v
+            auto major_t { -footprint.dv_major * height() };
+            auto minor_s { footprint.du_minor * width() };
+            auto minor_t { -footprint.dv_minor * height() };
+            auto major { std::sqrt(major_s * major_s + major_t * major_t) };
+            auto minor { std::sqrt(minor_s * minor_s + minor_t * minor_t) };
+            if (minor > major) {
+                std::swap(major, minor);
+                std::swap(major_s, minor_s);
+                std::swap(major_t, minor_t);
+            }
+            minor = std::max(minor, major / max_anisotropy);
+            if (!(minor > 0)) return bilinear<F>(0, s, t);
+
+            // The axes are semi-axes, so the footprint is 2 * minor across
+            const auto level { std::log2(2 * minor) };
+            const auto probes {
+                std::clamp(
+                    static_cast<int>(std::ceil(major / minor)),
+                    1,
+                    max_anisotropy
+                )
+            };
+            if (probes == 1) return trilinear<F>(level, s, t);
+
+            // Spread the probes evenly along the major axis, in texture space
+            const auto step_s { 2 * major_s / width() / probes };
+            const auto step_t { 2 * major_t / height() / probes };
+            Colour sum { 0, 0, 0 };
+            for (int k = 0; k < probes; k++) {
+                const auto offset { k + 0.5 - probes / 2.0 };
+                sum += trilinear<F>(
+                    level, s + offset * step_s, t + offset * step_t
+                );
+            }
+            return sum / probes;
+        }
+
+        // Cuts base and each level halving it into tiles. Of the levels
+        // after base, only the one being cut into tiles and the next are
+        // ever held whole.
+        template <typename Base>
+        void build(const Base& base) {
+            if (base.width <= 0 || base.height <= 0) return;
+
+            store(base);
+            if (base.width == 1 && base.height == 1) return;
+            for (auto level { downsample(base) }; ; level = downsample(level)) {
+                store(level);
+                if (level.width == 1 && level.height == 1) break;
+            }
+        }
+
+    public:
+        explicit MipMap(
+            const rtw_image& image,
+            TextureCache& cache = TextureCache::global()
+        ) : cache_ { cache },
+            image_ { cache.add_image() },
+            pinned_ { !cache.bounded() },
+            format_ {
+                image.is_hdr() ? TexelFormat::Half : TexelFormat::SRGB8
+            } {
+            if (image.height() <= 0) return;
+            build(ImageTexels { image, image.width(), image.height() });
+        }
+
+        // Pyramid over linear RGB texels given row by row, top row first,
+        // as for images generated rather than loaded
+        MipMap(
+            int width,
+            int height,
+            std::vector<float> texels,
+            TexelFormat format,
+            TextureCache& cache = TextureCache::global()
+        ) : cache_ { cache },
+            image_ { cache.add_image() },
+            pinned_ { !cache.bounded() },
+            format_ { format } {
+            build(Texels { width, height, std::move(texels) });
+        }
+
+        MipMap(const MipMap&) = delete;
+        MipMap& operator=(const MipMap&) = delete;
+
+        ~MipMap() {
+            cache_.remove_image(image_);
+        }
+
+        int levels() const { return static_cast<int>(levels_.size()); }
+        int width() const { return levels_.empty() ? 0 : levels_[0].width; }
+        int height() const { return levels_.empty() ? 0 : levels_[0].height; }
+
+        // Average over the footprint around (s, t). The level is picked so a
+        // texel spans the footprint's minor axis, and up to max_anisotropy
+        // trilinear lookups are spread along its major axis.
+        Colour lookup(
+            double s, double t, const TextureFootprint& footprint
+        ) const {
+            if (format_ == TexelFormat::SRGB8) {
+                return filter<TexelFormat::SRGB8>(s, t, footprint);
+            }
+            return filter<TexelFormat::Half>(s, t, footprint);
+        }
+};
+
+#endif
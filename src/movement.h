@@ -1,132 +1,315 @@
 #ifndef MOVEMENT_H
 #define MOVEMENT_H
 
+#include <memory>
+#include <utility>
+
 #include "vec3.h"
 #include "ray.h"
 #include "hittable.h"
+#include "transform.h"
+
+// Transforms defer shading like any primitive: hit() records what was hit
+// in object space as rec.instanced and the transform itself as rec.object,
+// and surface_interaction() re-derives the object space ray to complete the
+// final hit there before carrying it into the world. The record holds one
+// pending hit, so a transform that finds another beneath it, through an
+// aggregate, completes the inner hit at once instead.
+
+// hit() of transform, given the ray in object space and how to carry a
+// completed hit back into the world
+template <typename ToWorld>
+bool transform_hit(
+    const Hittable& transform,
+    const Hittable& object,
+    const Ray& local,
+    IntervalR t,
+    HitRecord& rec,
+    ToWorld to_world
+) {
+    // Cleared so that a transform beneath this one shows itself
+    const auto pending { std::exchange(rec.instanced, nullptr) };
+    if (!object.hit(local, t, rec)) {
+        rec.instanced = pending;
+        return false;
+    }
+
+    if (rec.instanced) {
+        rec.object->surface_interaction(local, rec);
+        to_world(rec);
+        rec.instanced = nullptr;
+    } else {
+        rec.instanced = rec.object;
+    }
+    rec.object = &transform;
+    return true;
+}
 
-class Translate : public Hittable {
+// surface_interaction() of a transform, given the ray in object space
+template <typename ToWorld>
+void transform_surface_interaction(
+    const Ray& local, HitRecord& rec, ToWorld to_world
+) {
+    const auto inner { std::exchange(rec.instanced, nullptr) };
+    if (!inner) return;
+    inner->surface_interaction(local, rec);
+    to_world(rec);
+}
+
+// An object placed in the world by an affine transform. The object, usually
+// a BVH, can be shared by any number of instances so memory follows the
+// unique geometry; a BVH over the instances is the top level of the
+// hierarchy.
+class Instance : public Hittable {
     private:
         std::shared_ptr<Hittable> object;
-        Direction3 offset;
+        Affine to_world;
+        Affine to_object;
         AABB bbox {};
 
+        explicit Instance(
+            std::pair<std::shared_ptr<Hittable>, Affine> flattened
+        )
+            : object { flattened.first }
+            , to_world { flattened.second }
+            , to_object { flattened.second.inverse() }
+            , bbox { flattened.second.bounds(object->bounding_box()) }
+        {}
+
+        // The direction is not renormalised, so t is the same in both spaces
+        Ray to_object_space(const Ray& r) const {
+            return Ray {
+                to_object.point(r.origin()),
+                to_object.direction(r.direction()),
+                r.time()
+            };
+        }
+
+        // Normals go through the inverse transpose, which keeps their
+        // orientation relative to the ray and so rec.front_face
+        void to_world_space(HitRecord& rec) const {
+            rec.p = to_world.point(rec.p);
+            rec.normal = unit_vector(to_object.transpose_direction(rec.normal));
+            rec.dpdu = to_world.direction(rec.dpdu);
+            rec.dpdv = to_world.direction(rec.dpdv);
+        }
+
     public:
-        Translate() = delete;
-        Translate(std::shared_ptr<Hittable> p, const Direction3& displacement)
-            : object { p }, offset { displacement } {
-                bbox = object->bounding_box() + offset;
-            }
+        Instance() = delete;
+        Instance(std::shared_ptr<Hittable> object, const Affine& transform)
+            : Instance { flatten(object, transform) } {}
 
-        bool hit(const Ray& r, IntervalD t, HitRecord& rec) const override {
-            Ray offset_r { r.origin() - offset, r.direction() };
-            if (!object->hit(offset_r, t, rec)) return false;
+        // An instance of an instance collapses into one: the transforms are
+        // composed at build time and the innermost object is referenced
+        // directly, so a ray is transformed once however deep the stack
+        static std::pair<std::shared_ptr<Hittable>, Affine> flatten(
+            std::shared_ptr<Hittable> object, const Affine& transform
+        ) {
+            const auto inner { std::dynamic_pointer_cast<Instance>(object) };
+            if (!inner) return { object, transform };
+            return { inner->object, transform * inner->to_world };
+        }
+
+        bool hit(const Ray& r, IntervalR t, HitRecord& rec) const override {
+            return transform_hit(
+                *this, *object, to_object_space(r), t, rec,
+                [this](HitRecord& rec) { to_world_space(rec); }
+            );
+        }
+
+        void surface_interaction(const Ray& r, HitRecord& rec) const override {
+            transform_surface_interaction(
+                to_object_space(r), rec,
+                [this](HitRecord& rec) { to_world_space(rec); }
+            );
+        }
+
+        bool occluded(const Ray& r, IntervalR t) const override {
+            return object->occluded(to_object_space(r), t);
+        }
+
+        double transmittance(const Ray& r, IntervalR t) const override {
+            return object->transmittance(to_object_space(r), t);
+        }
 
-            rec.p += offset;
-            return true;
+        bool span(const Ray& r, IntervalR& t) const override {
+            return object->span(to_object_space(r), t);
         }
 
         AABB bounding_box() const override {
             return bbox;
         }
+
+        // Mapping a box through a fixed transform is linear in its faces,
+        // so interpolation commutes with it
+        MotionAABB motion_bounding_box() const override {
+            const auto inner { object->motion_bounding_box() };
+            return MotionAABB {
+                to_world.bounds(inner.start()), to_world.bounds(inner.end())
+            };
+        }
 };
 
-class RotateY : public Hittable {
+class Translate : public Instance {
+    public:
+        Translate() = delete;
+        Translate(std::shared_ptr<Hittable> object, const Direction3& offset)
+            : Instance { object, Affine::translation(offset) } {}
+};
+
+class RotateY : public Instance {
+    public:
+        RotateY() = delete;
+        RotateY(std::shared_ptr<Hittable> object, double angle)
+            : Instance { object, Affine::rotation(Direction3(0, 1, 0), angle) }
+        {}
+};
+
+// An instance in motion over the shutter interval. At time 0 it is placed
+// by transform; by time 1 it has travelled by displacement and spun by
+// angle degrees about axis through its own origin, both at constant speed.
+// The geometry is shared as with Instance, only the placement is animated.
+class MotionInstance : public Hittable {
     private:
         std::shared_ptr<Hittable> object;
-        double sin_theta {};
-        double cos_theta {};
+        Affine to_world;
+        Affine to_object;
+        // Centre of the spin, the object's origin at time 0
+        Point3 pivot;
+        Direction3 displacement;
+        Direction3 axis;
+        double angle;
         AABB bbox {};
 
-        Point3 rotate(const Point3& p) const {
-            return Point3 {
-                cos_theta * p.x() - sin_theta * p.z(),
-                p.y(),
-                sin_theta * p.x() + cos_theta * p.z()
+        // Rodrigues' rotation of v about axis, given the angle's cosine and
+        // sine
+        Direction3 spin(const Direction3& v, Real cos_a, Real sin_a) const {
+            return v * cos_a
+                + cross(axis, v) * sin_a
+                + axis * (dot(axis, v) * (1 - cos_a));
+        }
+
+        std::pair<Real, Real> spin_at(Real time) const {
+            const auto a { angle * time };
+            return {
+                static_cast<Real>(std::cos(a)),
+                static_cast<Real>(std::sin(a))
             };
         }
 
-        Point3 derotate(const Point3& p) const {
-            return Point3 {
-                cos_theta * p.x() + sin_theta * p.z(),
-                p.y(),
-                -sin_theta * p.x() + cos_theta * p.z()
+        Ray to_object_space(const Ray& r, Real cos_a, Real sin_a) const {
+            const auto origin {
+                r.origin() - displacement * r.time() - pivot
+            };
+            return Ray {
+                to_object.point(pivot + spin(origin, cos_a, -sin_a)),
+                to_object.direction(spin(r.direction(), cos_a, -sin_a)),
+                r.time()
             };
         }
 
-        static std::pair<double, double> set_angles(double angle) {
-            const auto radians { degrees_to_radians(angle) };
-            return { std::sin(radians), std::cos(radians) };
+        void to_world_space(
+            HitRecord& rec, Real time, Real cos_a, Real sin_a
+        ) const {
+            const auto placed { to_world.point(rec.p) - pivot };
+            rec.p = pivot + spin(placed, cos_a, sin_a) + displacement * time;
+            rec.normal = unit_vector(spin(
+                to_object.transpose_direction(rec.normal), cos_a, sin_a
+            ));
+            rec.dpdu = spin(to_world.direction(rec.dpdu), cos_a, sin_a);
+            rec.dpdv = spin(to_world.direction(rec.dpdv), cos_a, sin_a);
         }
 
-        static AABB set_bounding_box(
-            const Hittable& object, double cos_theta, double sin_theta
-        ) {
-            const auto bbox { object.bounding_box() };
-
-            Point3 min { infinity_d, infinity_d, infinity_d };
-            Point3 max { -infinity_d, -infinity_d, -infinity_d };
-
-            for (int i = 0; i < 2; i++) {
-                for (int j = 0; j < 2; j++) {
-                    for (int k = 0; k < 2; k++) {
-                        const auto x {
-                            i * bbox.x().max() + (1 - i) * bbox.x().min()
-                        };
-                        const auto y {
-                            j * bbox.y().max() + (1 - j) * bbox.y().min()
-                        };
-                        const auto z {
-                            k * bbox.z().max() + (1 - k) * bbox.z().min()
-                        };
-
-                        const auto newx { cos_theta * x + sin_theta * z };
-                        const auto newz { -sin_theta * x + cos_theta * z };
-
-                        Direction3 tester { newx, y, newz };
-
-                        for (int c = 0; c < 3; c++) {
-                            min[c] = std::min(min[c], tester[c]);
-                            max[c] = std::max(max[c], tester[c]);
-                        }
-                    }
+        // Box around every placement: spinning keeps the object within a
+        // sphere about the pivot, which then sweeps along displacement
+        AABB motion_bounds() const {
+            const auto start { to_world.bounds(object->bounding_box()) };
+            auto swept { start };
+            if (angle != 0) {
+                Real radius { 0 };
+                for (int i = 0; i < 8; i++) {
+                    const Point3 corner {
+                        (i & 1) ? start.x().max() : start.x().min(),
+                        (i & 2) ? start.y().max() : start.y().min(),
+                        (i & 4) ? start.z().max() : start.z().min()
+                    };
+                    radius = std::max(radius, (corner - pivot).length());
                 }
+                const Direction3 extent { radius, radius, radius };
+                swept = AABB { pivot - extent, pivot + extent };
             }
-
-            return AABB { min, max };
+            return AABB { swept, swept + displacement };
         }
 
     public:
-        RotateY() = delete;
-        RotateY(std::shared_ptr<Hittable> object, double angle)
-            : object { object }
-            , sin_theta { set_angles(angle).first }
-            , cos_theta { set_angles(angle).second }
-            , bbox { set_bounding_box(*object, cos_theta, sin_theta) }
+        MotionInstance() = delete;
+        MotionInstance(
+            std::shared_ptr<Hittable> object,
+            const Affine& transform,
+            const Direction3& displacement,
+            const Direction3& axis = Direction3(0, 1, 0),
+            double angle = 0
+        ) : object { Instance::flatten(object, transform).first }
+          , to_world { Instance::flatten(object, transform).second }
+          , to_object { to_world.inverse() }
+          , pivot { to_world.point(Point3(0, 0, 0)) }
+          , displacement { displacement }
+          , axis { unit_vector(axis) }
+          , angle { degrees_to_radians(angle) }
+          , bbox { motion_bounds() }
         {}
 
-        bool hit(const Ray& r, IntervalD t, HitRecord& rec) const override {
-
-            // Transform Ray from world space to object space
-            const auto origin { rotate(r.origin()) };
-            const auto direction { rotate(r.direction()) };
-
-            Ray rotated_r { origin, direction, r.time() };
+        bool hit(const Ray& r, IntervalR t, HitRecord& rec) const override {
+            const auto [cos_a, sin_a] { spin_at(r.time()) };
+            return transform_hit(
+                *this, *object, to_object_space(r, cos_a, sin_a), t, rec,
+                [&](HitRecord& rec) {
+                    to_world_space(rec, r.time(), cos_a, sin_a);
+                }
+            );
+        }
 
-            // Determine if there's a hit in object space
+        void surface_interaction(const Ray& r, HitRecord& rec) const override {
+            const auto [cos_a, sin_a] { spin_at(r.time()) };
+            transform_surface_interaction(
+                to_object_space(r, cos_a, sin_a), rec,
+                [&](HitRecord& rec) {
+                    to_world_space(rec, r.time(), cos_a, sin_a);
+                }
+            );
+        }
 
-            if (!object->hit(rotated_r, t, rec)) return false;
+        bool occluded(const Ray& r, IntervalR t) const override {
+            const auto [cos_a, sin_a] { spin_at(r.time()) };
+            return object->occluded(to_object_space(r, cos_a, sin_a), t);
+        }
 
-            // Transform intersection back to world space
+        double transmittance(const Ray& r, IntervalR t) const override {
+            const auto [cos_a, sin_a] { spin_at(r.time()) };
+            return object->transmittance(
+                to_object_space(r, cos_a, sin_a), t
+            );
+        }
 
-            rec.p = derotate(rec.p);
-            rec.normal = derotate(rec.normal);
-            return true;
+        bool span(const Ray& r, IntervalR& t) const override {
+            const auto [cos_a, sin_a] { spin_at(r.time()) };
+            return object->span(to_object_space(r, cos_a, sin_a), t);
         }
 
         AABB bounding_box() const override {
             return bbox;
         }
+
+        // A pure translation moves the object's own bounds in a straight
+        // line. Spinning does not, so the swept box is used at both ends.
+        MotionAABB motion_bounding_box() const override {
+            if (angle != 0) return bbox;
+            const auto inner { object->motion_bounding_box() };
+            return MotionAABB {
+                to_world.bounds(inner.start()),
+                to_world.bounds(inner.end()) + displacement
+            };
+        }
 };
 
 #endif
@@ -0,0 +1,36 @@
+#ifndef ONB_H
+#define ONB_H
+
+#include <cmath>
+
+#include "vec3.h"
+
+// Orthonormal basis with w aligned to a given direction
+class ONB {
+    private:
+        Direction3 axis[3];
+
+    public:
+        ONB() = delete;
+        explicit ONB(const Direction3& n) {
+            axis[2] = unit_vector(n);
+            const auto a {
+                std::fabs(axis[2].x()) > 0.9
+                    ? Direction3 { 0, 1, 0 }
+                    : Direction3 { 1, 0, 0 }
+            };
+            axis[1] = unit_vector(cross(axis[2], a));
+            axis[0] = cross(axis[2], axis[1]);
+        }
+
+        const Direction3& u() const { return axis[0]; }
+        const Direction3& v() const { return axis[1]; }
+        const Direction3& w() const { return axis[2]; }
+
+        // Transform from basis coordinates to world space
+        Direction3 transform(const Direction3& v) const {
+            return (v[0] * axis[0]) + (v[1] * axis[1]) + (v[2] * axis[2]);
+        }
+};
+
+#endif
@@ -1,59 +1,147 @@
 #ifndef PERLIN_H
 #define PERLIN_H
 
-#include "random.h"
+#include "simd.h"
 #include "vec3.h"
+#include <algorithm>
 #include <array>
-
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <utility>
+
+// Perlin noise evaluated a lane at a time: noise() interpolates its eight
+// lattice corners in two groups of four, and turb() evaluates four octaves
+// at once, one per lane. Each lane repeats the arithmetic of the plain
+// scalar loops in the same order, so results are bit for bit the same as
+// theirs in double precision builds without -ffast-math. The tables are
+// built once, from a fixed seed, and shared by every noise texture.
 class Perlin {
     private:
+        using Lanes = simd::Lanes<double>;
+        static constexpr int lanes { 4 };
+
         static constexpr int point_count { 256 };
-        const std::array<Direction3, point_count> rand_vec;
-        const std::array<int, point_count> perm_x;
-        const std::array<int, point_count> perm_y;
-        const std::array<int, point_count> perm_z;
+        // Fixed, so the noise is the same in every run and every scene.
+        // The tables are drawn straight from the engine's output, which the
+        // standard pins down, rather than through distributions, which it
+        // leaves to each library.
+        static constexpr std::mt19937::result_type seed { 0x9e3779b9 };
+
+        // Unit gradients, one array per axis so that a lane's worth of one
+        // component is gathered from a single array
+        std::array<float, point_count> grad_x {};
+        std::array<float, point_count> grad_y {};
+        std::array<float, point_count> grad_z {};
+        std::array<std::uint8_t, point_count> perm_x {};
+        std::array<std::uint8_t, point_count> perm_y {};
+        std::array<std::uint8_t, point_count> perm_z {};
+
+        // Uniform in [-1, 1]
+        static double random_unit(std::mt19937& generator) {
+            return 2 * (generator() / 4294967296.0) - 1;
+        }
 
-        static std::array<Direction3, point_count> gen_rand_vec() {
-            std::array<Direction3, point_count> p {};
+        static void permute(
+            std::array<std::uint8_t, point_count>& p, std::mt19937& generator
+        ) {
             for (int i { 0 }; i < point_count; i++) {
-                p[i] = unit_vector(Direction3::random(-1, 1));
+                p[i] = static_cast<std::uint8_t>(i);
+            }
+            for (int i { point_count-1 }; i > 0; i--) {
+                const auto target { generator() % (i + 1) };
+                std::swap(p[i], p[target]);
             }
-            return p;
         }
 
-        static std::array<int, point_count> perlin_generate_perm() {
-            std::array<int, point_count> p {};
+        Perlin() {
+            std::mt19937 generator { seed };
             for (int i { 0 }; i < point_count; i++) {
-                p[i] = i;
+                const auto x { random_unit(generator) };
+                const auto y { random_unit(generator) };
+                const auto z { random_unit(generator) };
+                const auto g { unit_vector(Vec3<double> { x, y, z }) };
+                grad_x[i] = static_cast<float>(g.x());
+                grad_y[i] = static_cast<float>(g.y());
+                grad_z[i] = static_cast<float>(g.z());
             }
+            permute(perm_x, generator);
+            permute(perm_y, generator);
+            permute(perm_z, generator);
+        }
 
-            permute(p);
-            return p;
+        int hash(int i, int j, int k) const {
+            return perm_x[i & (point_count-1)]
+                ^ perm_y[j & (point_count-1)]
+                ^ perm_z[k & (point_count-1)];
         }
 
-        static void permute(std::array<int, point_count>& p) {
-            for (int i { point_count-1 }; i > 0; i--) {
-                const int target { gen_rand::random_int(0, i) };
-                std::swap(p[i], p[target]);
-            }
+        // Gradients for four hashes, one per lane. Each vector is built
+        // whole, as filling it lane by lane round trips it through memory.
+        void gradients(
+            const int h[lanes], Lanes& gx, Lanes& gy, Lanes& gz
+        ) const {
+            const auto gather { [h](const std::array<float, point_count>& a) {
+                return Lanes { a[h[0]], a[h[1]], a[h[2]], a[h[3]] };
+            } };
+            gx = gather(grad_x);
+            gy = gather(grad_y);
+            gz = gather(grad_z);
         }
 
-        static double perlin_interp(
-            const Direction3 c[2][2][2], double u, double v, double w
-        ) {
-            const auto uu { u*u*(3-2*u) };
-            const auto vv { v*v*(3-2*v) };
-            const auto ww { w*w*(3-2*w) };
-            auto accum { 0.0 };
+        static Lanes smooth(const Lanes& t) {
+            return t * t * (simd::broadcast(3.0) - simd::broadcast(2.0) * t);
+        }
+
+        // Noise at four points, one per lane, each summing its corners in
+        // the order of the scalar code
+        Lanes noise4(const Lanes& x, const Lanes& y, const Lanes& z) const {
+            Lanes u {}, v {}, w {};
+            // Permutations of each lane's two lattice planes along each axis,
+            // so a corner's hash is two xors of them
+            int px[2][lanes] {}, py[2][lanes] {}, pz[2][lanes] {};
+            for (int l { 0 }; l < lanes; l++) {
+                const auto fx { std::floor(x[l]) };
+                const auto fy { std::floor(y[l]) };
+                const auto fz { std::floor(z[l]) };
+                u[l] = x[l] - fx;
+                v[l] = y[l] - fy;
+                w[l] = z[l] - fz;
+                const auto i { static_cast<int>(fx) };
+                const auto j { static_cast<int>(fy) };
+                const auto k { static_cast<int>(fz) };
+                for (int d { 0 }; d < 2; d++) {
+                    px[d][l] = perm_x[(i + d) & (point_count-1)];
+                    py[d][l] = perm_y[(j + d) & (point_count-1)];
+                    pz[d][l] = perm_z[(k + d) & (point_count-1)];
+                }
+            }
 
-            for (int i { 0 }; i < 2; i++) {
-                for (int j { 0 }; j < 2; j++) {
-                    for (int k { 0 }; k < 2; k++) {
-                        const auto weight_v { Vec3(u-i, v-j, w-k) };
-                        accum += (i*uu + (1-i)*(1-uu))
-                            * (j*vv + (1-j)*(1-vv))
-                            * (k*ww + (1-k)*(1-ww))
-                            * dot(c[i][j][k], weight_v);
+            const auto one { simd::broadcast(1.0) };
+            const auto uu { smooth(u) };
+            const auto vv { smooth(v) };
+            const auto ww { smooth(w) };
+            auto accum { simd::broadcast(0.0) };
+
+            for (int di { 0 }; di < 2; di++) {
+                for (int dj { 0 }; dj < 2; dj++) {
+                    for (int dk { 0 }; dk < 2; dk++) {
+                        int h[lanes] {};
+                        for (int l { 0 }; l < lanes; l++) {
+                            h[l] = px[di][l] ^ py[dj][l] ^ pz[dk][l];
+                        }
+                        Lanes gx {}, gy {}, gz {};
+                        gradients(h, gx, gy, gz);
+                        const auto dx { di ? u - one : u };
+                        const auto dy { dj ? v - one : v };
+                        const auto dz { dk ? w - one : w };
+                        const auto weight {
+                            (di ? uu : one - uu)
+                            * (dj ? vv : one - vv)
+                            * (dk ? ww : one - ww)
+                        };
+                        accum = accum
+                            + weight * (gx * dx + gy * dy + gz * dz);
                     }
                 }
             }
@@ -62,12 +150,14 @@ class Perlin {
         }
 
     public:
-        Perlin()
-            : rand_vec { gen_rand_vec() }
-            , perm_x { perlin_generate_perm() }
-            , perm_y { perlin_generate_perm() }
-            , perm_z { perlin_generate_perm() }
-        {}
+        Perlin(const Perlin&) = delete;
+        Perlin& operator=(const Perlin&) = delete;
+
+        // The tables every noise texture shares, built on first use
+        static const Perlin& shared() {
+            static const Perlin perlin {};
+            return perlin;
+        }
 
         double noise(const Point3& p) const {
             const auto u { p.x() - std::floor(p.x()) };
@@ -78,20 +168,42 @@ class Perlin {
             const auto j { static_cast<int>(std::floor(p.y())) };
             const auto k { static_cast<int>(std::floor(p.z())) };
 
-            Direction3 c[2][2][2] {};
+            // Corners (di, dj, dk) in lanes, dk varying fastest: those with
+            // di = 0 in the first group and di = 1 in the second
+            const Lanes dj { 0, 0, 1, 1 };
+            const Lanes dk { 0, 1, 0, 1 };
+            const auto one { simd::broadcast(1.0) };
+            const double vv { v*v*(3-2*v) };
+            const double ww { w*w*(3-2*w) };
+            const auto wy {
+                dj * simd::broadcast(vv) + (one - dj) * simd::broadcast(1 - vv)
+            };
+            const auto wz {
+                dk * simd::broadcast(ww) + (one - dk) * simd::broadcast(1 - ww)
+            };
+            const auto dy { simd::broadcast<double>(v) - dj };
+            const auto dz { simd::broadcast<double>(w) - dk };
+            const double uu { u*u*(3-2*u) };
+
+            auto accum { 0.0 };
             for (int di { 0 }; di < 2; di++) {
-                for (int dj { 0 }; dj < 2; dj++) {
-                    for (int dk { 0 }; dk < 2; dk++) {
-                        c[di][dj][dk] = rand_vec[
-                            perm_x[(i+di) & (point_count-1)] ^
-                            perm_y[(j+dj) & (point_count-1)] ^
-                            perm_z[(k+dk) & (point_count-1)]
-                        ];
-                    }
+                int h[lanes] {};
+                for (int l { 0 }; l < lanes; l++) {
+                    h[l] = hash(i + di, j + (l >> 1), k + (l & 1));
+                }
+                Lanes gx {}, gy {}, gz {};
+                gradients(h, gx, gy, gz);
+                const auto dx { simd::broadcast<double>(u - di) };
+                const auto wx { simd::broadcast(di ? uu : 1 - uu) };
+                const auto terms {
+                    wx * wy * wz * (gx * dx + gy * dy + gz * dz)
+                };
+                for (int l { 0 }; l < lanes; l++) {
+                    accum += terms[l];
                 }
             }
 
-            return perlin_interp(c, u, v, w);
+            return accum;
         }
 
         double turb(const Point3& p, int depth) const {
@@ -99,10 +211,21 @@ class Perlin {
             auto temp_p { p };
             auto weight { 1.0 };
 
-            for (int i { 0 }; i < depth; i++) {
-                accum += weight * noise(temp_p);
-                weight *= 0.5;
-                temp_p *= 2;
+            for (int octave { 0 }; octave < depth; octave += lanes) {
+                const auto count { std::min(lanes, depth - octave) };
+                Lanes x {}, y {}, z {};
+                for (int l { 0 }; l < count; l++) {
+                    x[l] = temp_p.x();
+                    y[l] = temp_p.y();
+                    z[l] = temp_p.z();
+                    temp_p *= 2;
+                }
+
+                const auto n { noise4(x, y, z) };
+                for (int l { 0 }; l < count; l++) {
+                    accum += weight * n[l];
+                    weight *= 0.5;
+                }
             }
 
             return std::fabs(accum);
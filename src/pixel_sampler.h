@@ -1,6 +1,7 @@
 #ifndef PIXEL_SAMPLER_H
 #define PIXEL_SAMPLER_H
 
+#include <cmath>
 #include <memory>
 
 #include "colour.h"
@@ -14,6 +15,17 @@ protected:
     SamplerDataPtr data;
     SamplerConfigPtr cfg;
     int i, j;
+    // Random start of the pixel's sequence of shutter times
+    double time_offset_ { gen_rand::random_double() };
+
+    // The golden ratio sequence, shifted by the pixel's offset. Every prefix
+    // of it is spread evenly over the shutter interval, so the time strata
+    // stay balanced even when adaptive sampling stops early.
+    double sample_time() const {
+        constexpr double inv_golden_ratio { 0.6180339887498949 };
+        const auto u { time_offset_ + samples_ * inv_golden_ratio };
+        return data->exposure.time(u - std::floor(u));
+    }
 
     Point3 get_pixel_point(const Direction3& offset) const {
         return data->pixel00_loc
@@ -49,7 +61,7 @@ public:
         const auto pixel_sample { sample_pixel() };
         const auto ray_origin { sample_defocus_disk() };
         const auto ray_direction { pixel_sample - ray_origin };
-        const auto ray_time { gen_rand::random_double(0, 1) };
+        const Real ray_time { static_cast<Real>(sample_time()) };
         samples_++;
         return Ray { ray_origin, ray_direction, ray_time };
     };
@@ -106,11 +118,11 @@ public:
 class RandomPixelSampler : public PixelSampler {
 private:
     static Direction3 sample_square() {
-        return Direction3 {
+        return Direction3 { Vec3 {
             gen_rand::random_double(-0.5, 0.5),
             gen_rand::random_double(-0.5, 0.5),
-            0
-        };
+            0.0
+        } };
     }
 
     Point3 sample_pixel() const override {
@@ -134,15 +146,15 @@ public:
 class AdaptiveRandomPixelSampler : public RandomPixelSampler {
 private:
     struct Data {
-        Point3 s1{0,0,0};  // Sum for each channel
-        Point3 s2{0,0,0};  // Sum of squares for each channel
+        Colour s1{0,0,0};  // Sum for each channel
+        Colour s2{0,0,0};  // Sum of squares for each channel
     };
 
     Data sampling_data {};
 
-    Point3 nvariance() const {
+    Colour nvariance() const {
         if (samples() <= 1) {
-            return Point3 { infinity_d, infinity_d, infinity_d };
+            return Colour { infinity_d, infinity_d, infinity_d };
         }
         const auto s1_squared { sampling_data.s1 * sampling_data.s1 };
         return (sampling_data.s2 - (s1_squared / samples()));
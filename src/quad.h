@@ -2,8 +2,10 @@
 #define QUAD_H
 
 #include <memory>
+#include <utility>
 
 #include "aabb.h"
+#include "arena.h"
 #include "hittable.h"
 #include "material.h"
 #include "vec3.h"
@@ -18,7 +20,9 @@ class Surface : public Hittable {
         const Direction3 w_;
         const std::shared_ptr<Material> mat_;
         const Direction3 normal_;
-        const double D_;
+        const Real D_;
+        // Area of the parallelogram spanned by u and v
+        const double span_area_;
         // Struct to cache bounding box
         mutable struct {
             bool set { false };
@@ -35,12 +39,15 @@ class Surface : public Hittable {
         static Direction3 get_unit_normal(const Direction3& w) {
             return unit_vector(w);
         }
-        static double get_D(const Direction3& normal, const Point3& Q) {
+        static Real get_D(const Direction3& normal, const Point3& Q) {
             return dot(normal, Q);
         }
 
         virtual AABB get_bounding_box() const = 0;
-        virtual bool is_interior(double a, double b, HitRecord& rec) const = 0;
+        virtual bool is_interior(Real a, Real b) const = 0;
+        // Uniformly distributed plane coordinates of an interior point
+        virtual std::pair<double, double> sample_interior() const = 0;
+        virtual double area() const = 0;
 
     public:
         Surface() = delete;
@@ -56,6 +63,7 @@ class Surface : public Hittable {
             , mat_ { mat }
             , normal_ { get_unit_normal(w_) }
             , D_ { dot(normal_, Q_) }
+            , span_area_ { cross(u, v).length() }
         {}
 
         AABB bounding_box() const override {
@@ -66,31 +74,82 @@ class Surface : public Hittable {
             return bbox_.bbox;
         }
 
-        bool hit(
+        // Plane intersection within ray_t, with the hit's plane coordinates
+        bool intersect(
             const Ray& r,
-            IntervalD ray_t,
-            HitRecord& rec
-        ) const override {
+            IntervalR ray_t,
+            Real& t,
+            Real& alpha,
+            Real& beta
+        ) const {
             const auto denom { dot(normal_, r.direction()) };
 
             if (std::fabs(denom) < 1e-8) return false;
 
-            const auto t { (D_ - dot(normal_, r.origin())) / denom };
+            t = (D_ - dot(normal_, r.origin())) / denom;
             if (!ray_t.contains(t)) return false;
 
-            const auto intersection { r.at(t) };
-            const auto pos_on_plane { intersection - Q_ };
-            const auto alpha { dot(w_, cross(pos_on_plane, v_)) };
-            const auto beta { dot(w_, cross(u_, pos_on_plane)) };
+            const auto pos_on_plane { r.at(t) - Q_ };
+            alpha = dot(w_, cross(pos_on_plane, v_));
+            beta = dot(w_, cross(u_, pos_on_plane));
+
+            return is_interior(alpha, beta);
+        }
+
+        bool hit(
+            const Ray& r,
+            IntervalR ray_t,
+            HitRecord& rec
+        ) const override {
+            Real t {}, alpha {}, beta {};
+            if (!intersect(r, ray_t, t, alpha, beta)) return false;
 
-            if (!is_interior(alpha, beta, rec)) return false;
             rec.t = t;
-            rec.p = intersection;
-            rec.mat = mat_;
-            rec.set_face_normal(r, normal_);
+            rec.u = alpha;
+            rec.v = beta;
+            rec.object = this;
 
             return true;
         }
+
+        void surface_interaction(
+            const Ray& r, HitRecord& rec
+        ) const override {
+            rec.p = r.at(rec.t);
+            rec.mat = mat_.get();
+            rec.set_face_normal(r, normal_);
+            rec.dpdu = u_;
+            rec.dpdv = v_;
+        }
+
+        bool occluded(const Ray& r, IntervalR ray_t) const override {
+            Real t {}, alpha {}, beta {};
+            return intersect(r, ray_t, t, alpha, beta);
+        }
+
+        double pdf_value(
+            const Point3& origin, const Direction3& direction
+        ) const override {
+            Real t {}, alpha {}, beta {};
+            if (!intersect(
+                Ray { origin, direction },
+                IntervalR { 0.001, infinity_r },
+                t, alpha, beta
+            )) return 0;
+
+            const auto distance_squared {
+                t * t * direction.length_squared()
+            };
+            const auto cosine {
+                std::fabs(dot(direction, normal_) / direction.length())
+            };
+            return distance_squared / (cosine * area());
+        }
+
+        Direction3 random(const Point3& origin) const override {
+            const auto [a, b] { sample_interior() };
+            return Q_ + (a * u_) + (b * v_) - origin;
+        }
 };
 
 class Quad : public Surface {
@@ -101,14 +160,17 @@ class Quad : public Surface {
             return AABB(box_0, box_1);
         }
 
-        bool is_interior(double a, double b, HitRecord& rec) const override {
-            const IntervalD unit { 0, 1 };
-            if (!unit.contains(a) || !unit.contains(b)) return false;
-            rec.u = a;
-            rec.v = b;
-            return true;
+        bool is_interior(Real a, Real b) const override {
+            const IntervalR unit { 0, 1 };
+            return unit.contains(a) && unit.contains(b);
+        }
+
+        std::pair<double, double> sample_interior() const override {
+            return { gen_rand::random_double(), gen_rand::random_double() };
         }
 
+        double area() const override { return span_area_; }
+
     public:
         Quad(
             const Point3& Q,
@@ -126,16 +188,23 @@ class Triangle : public Surface {
             return AABB(box_0, box_1);
         }
 
-        bool is_interior(double a, double b, HitRecord& rec) const override {
-            const IntervalD unit { 0, 1 };
+        bool is_interior(Real a, Real b) const override {
+            const IntervalR unit { 0, 1 };
             if (!unit.contains(a) || !unit.contains(b)) return false;
-            if (a + b > 1) return false;
+            return a + b <= 1;
+        }
 
-            rec.u = a;
-            rec.v = b;
-            return true;
+        std::pair<double, double> sample_interior() const override {
+            const auto a { gen_rand::random_double() };
+            const auto b { gen_rand::random_double() };
+            // Fold the far half of the unit square back onto the triangle
+            return a + b > 1
+                ? std::pair<double, double> { 1 - a, 1 - b }
+                : std::pair<double, double> { a, b };
         }
 
+        double area() const override { return 0.5 * span_area_; }
+
     public:
         Triangle(
             const Point3& Q,
@@ -153,13 +222,18 @@ class Ellipse : public Surface {
             return AABB(box_0, box_1);
         }
 
-        bool is_interior(double a, double b, HitRecord& rec) const override {
-            if (a * a + b * b > 1) return false;
-            rec.u = a;
-            rec.v = b;
-            return true;
+        bool is_interior(Real a, Real b) const override {
+            return a * a + b * b <= 1;
         }
 
+        std::pair<double, double> sample_interior() const override {
+            const auto r { std::sqrt(gen_rand::random_double()) };
+            const auto theta { gen_rand::random_double(0, 2 * pi) };
+            return { r * std::cos(theta), r * std::sin(theta) };
+        }
+
+        double area() const override { return pi * span_area_; }
+
     public:
         Ellipse(
             const Point3& Q,
@@ -175,7 +249,7 @@ class Disc : public Ellipse {
             const Point3& Q,
             const Direction3& u,
             const Direction3& v,
-            double radius,
+            Real radius,
             std::shared_ptr<Material> mat
         ) : Ellipse {
             Q,
@@ -187,12 +261,29 @@ class Disc : public Ellipse {
         } {}
 };
 
-inline std::shared_ptr<HittableList> box(
+// Axis-aligned box made of six quads, which are what rays hit. Being
+// convex and axis-aligned, the span a ray spends inside it is simply the
+// ray's clip against its bounds.
+class Box : public HittableList {
+    private:
+        AABB bounds;
+
+    public:
+        Box() = delete;
+        Box(const Point3& a, const Point3& b) : bounds { a, b } {}
+
+        bool span(const Ray& r, IntervalR& t) const override {
+            return bounds.clip(r, t);
+        }
+};
+
+inline std::shared_ptr<Box> box(
     const Point3& a,
     const Point3& b,
-    std::shared_ptr<Material> mat
+    std::shared_ptr<Material> mat,
+    Arena& arena
 ) {
-    const auto sides { std::make_shared<HittableList>() };
+    const auto sides { arena.make<Box>(a, b) };
 
     const auto min { Point3(
         std::min(a.x(), b.x()),
@@ -210,27 +301,27 @@ inline std::shared_ptr<HittableList> box(
     const auto dz { Direction3(0, 0, max.z() - min.z()) };
 
     // Front face (z = max.z)
-    sides->add(std::make_shared<Quad>(
+    sides->add(arena.make<Quad>(
         Point3 { min.x(), min.y(), max.z() }, dx, dy, mat
     ));
     // Right face (x = max.x)
-    sides->add(std::make_shared<Quad>(
+    sides->add(arena.make<Quad>(
         Point3 { max.x(), min.y(), max.z() }, -dz, dy, mat
     ));
     // Back face (z = min.z)
-    sides->add(std::make_shared<Quad>(
+    sides->add(arena.make<Quad>(
         Point3 { max.x(), min.y(), min.z() }, -dx, dy, mat
     ));
     // Left face (x = min.x)
-    sides->add(std::make_shared<Quad>(
+    sides->add(arena.make<Quad>(
         Point3 { min.x(), min.y(), min.z() }, dz, dy, mat
     ));
     // Top face (y = max.y)
-    sides->add(std::make_shared<Quad>(
+    sides->add(arena.make<Quad>(
         Point3 { min.x(), max.y(), min.z() }, dx, dz, mat
     ));
     // Bottom face (y = min.y)
-    sides->add(std::make_shared<Quad>(
+    sides->add(arena.make<Quad>(
         Point3 { min.x(), min.y(), min.z() }, dx, dz, mat
     ));
 
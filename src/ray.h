@@ -1,28 +1,90 @@
 #ifndef RAY_H
 #define RAY_H
 
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#include "concepts.h"
 #include "vec3.h"
 
-class Ray {
+template <Arithmetic T>
+class BasicRay {
 private:
-    Point3 origin_ {};
-    Direction3 direction_ {};
-    double time_ {};
+    Vec3<T> origin_ {};
+    Vec3<T> direction_ {};
+    // Cached for slab tests against bounding boxes
+    Vec3<T> inv_direction_ {};
+    int sign_[3] {};
+    T time_ {};
+
 public:
     // Default constructor: a ray with zero origin, direction, and time
-    Ray() = default;
-    Ray(
-        const Point3& origin,
-        const Direction3& direction,
-        double time = 0.0
-    ) : origin_ { origin }, direction_ { direction }, time_ { time } {}
+    BasicRay() = default;
+    BasicRay(
+        const Vec3<T>& origin,
+        const Vec3<T>& direction,
+        T time = 0
+    ) : origin_ { origin }
+        , direction_ { direction }
+        , inv_direction_ {
+            1 / direction.x(), 1 / direction.y(), 1 / direction.z()
+        }
+        , sign_ {
+            inv_direction_.x() < 0,
+            inv_direction_.y() < 0,
+            inv_direction_.z() < 0
+        }
+        , time_ { time } {}
 
     const auto& origin() const { return origin_; }
     const auto& direction() const { return direction_; }
+    const auto& inv_direction() const { return inv_direction_; }
+    // 1 if the direction is negative along axis, else 0
+    int sign(int axis) const { return sign_[axis]; }
+
+    T time() const { return time_; }
 
-    double time() const { return time_; }
+    Vec3<T> at(T t) const { return origin_ + t * direction_; }
 
-    Point3 at(double t) const { return origin_ + t * direction_; }
+    // Same ray from a different origin, reusing the cached direction data
+    BasicRay with_origin(const Vec3<T>& origin) const {
+        BasicRay r { *this };
+        r.origin_ = origin;
+        return r;
+    }
 };
 
+using Ray = BasicRay<Real>;
+
+// Moves a point computed on a surface off it along the normal n (pointing to
+// the side the new ray leaves from) by a number of ulps that scales with the
+// point's magnitude, so rays spawned there cannot re-intersect the surface.
+// Close to the origin, where ulps are tiny, a fixed offset is used instead.
+// After Waechter and Binder, "A Fast and Robust Method for Avoiding
+// Self-Intersection", Ray Tracing Gems (2019).
+template <Arithmetic T>
+inline Vec3<T> offset_ray_origin(const Vec3<T>& p, const Vec3<T>& n) {
+    using Bits = std::conditional_t<
+        sizeof(T) == 4, std::int32_t, std::int64_t
+    >;
+    constexpr T origin { T(1) / 32 };
+    constexpr T float_scale { T(1) / 65536 };
+    constexpr T int_scale { 256 };
+
+    Vec3<T> offset_p {};
+    for (int i = 0; i < 3; i++) {
+        const auto of_i { static_cast<Bits>(int_scale * n[i]) };
+        const auto p_bits { std::bit_cast<Bits>(p[i]) };
+        const auto p_i {
+            std::bit_cast<T>(p_bits + ((p[i] < 0) ? -of_i : of_i))
+        };
+        offset_p[i] = std::fabs(p[i]) < origin
+            ? p[i] + float_scale * n[i]
+            : p_i;
+    }
+    return offset_p;
+}
+
 #endif
@@ -6,12 +6,21 @@
 
 #include "concepts.h"
 
+// Scalar type of the geometry pipeline: points, directions, rays, bounds and
+// ray parameters. Shading (colours, textures, pdfs) always uses double.
+#ifdef RAYTRACER_SINGLE_PRECISION
+using Real = float;
+#else
+using Real = double;
+#endif
+
 // Constants
 
 template <Arithmetic T>
 constexpr T infinity = std::numeric_limits<T>::infinity();
 
 constexpr double infinity_d = infinity<double>;
+constexpr Real infinity_r = infinity<Real>;
 
 constexpr double pi = std::numbers::pi;
 
@@ -5,8 +5,16 @@
 #define STBI_FAILURE_USERMSG
 #include "external/stb_image.h"
 
+#include "texel.h"
+
+#include <array>
 #include <cstdlib>
+#include <filesystem>
 #include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 class rtw_image {
     public:
@@ -20,64 +28,98 @@ class rtw_image {
             // parent, on so on, for six levels up. If the image was not loaded successfully,
             // width() and height() will return 0.
 
-            auto filename = std::string(image_filename);
-            auto imagedir = getenv("RTW_IMAGES");
-
-            // Hunt for the image file in some likely locations.
-            if (imagedir && load(std::string(imagedir) + "/" + image_filename)) return;
-            if (load(filename)) return;
-            if (load("src/images/" + filename)) return;
-            if (load("images/" + filename)) return;
-            if (load("../images/" + filename)) return;
-            if (load("../../images/" + filename)) return;
-            if (load("../../../images/" + filename)) return;
-            if (load("../../../../images/" + filename)) return;
-            if (load("../../../../../images/" + filename)) return;
-            if (load("../../../../../../images/" + filename)) return;
+            auto filename = resolve(image_filename);
+            if (!filename.empty() && load(filename)) return;
 
             std::cerr << "ERROR: Could not load image file '" << image_filename << "'.\n";
         }
 
+        rtw_image(const rtw_image&) = delete;
+        rtw_image& operator=(const rtw_image&) = delete;
+
         ~rtw_image() {
-            delete[] bdata;
+            STBI_FREE(bdata);
             STBI_FREE(fdata);
         }
 
         bool load(const std::string& filename) {
-            // Loads the linear (gamma=1) image data from the given file name. Returns true if the
-            // load succeeded. The resulting data buffer contains the three [0.0, 1.0]
-            // floating-point values for the first pixel (red, then green, then blue). Pixels are
-            // contiguous, going left to right for the width of the image, followed by the next row
-            // below, for the full height of the image.
+            // Loads the image data from the given file name, decoded once into a single buffer.
+            // Returns true if the load succeeded. High dynamic range images keep their linear
+            // floating-point values; all others keep their 8-bit sRGB-encoded bytes, converted to
+            // linear only as pixels are read. Either way the buffer holds the three components of
+            // the first pixel (red, then green, then blue). Pixels are contiguous, going left to
+            // right for the width of the image, followed by the next row below, for the full
+            // height of the image.
 
             auto n = bytes_per_pixel; // Dummy out parameter: original components per pixel
-            fdata = stbi_loadf(filename.c_str(), &image_width, &image_height, &n, bytes_per_pixel);
-            if (fdata == nullptr) return false;
+            if (stbi_is_hdr(filename.c_str())) {
+                fdata = stbi_loadf(
+                    filename.c_str(), &image_width, &image_height, &n, bytes_per_pixel);
+            } else {
+                bdata = stbi_load(
+                    filename.c_str(), &image_width, &image_height, &n, bytes_per_pixel);
+            }
+            if (fdata == nullptr && bdata == nullptr) return false;
 
             bytes_per_scanline = image_width * bytes_per_pixel;
-            convert_to_bytes();
             return true;
         }
 
-        int width()  const { return (fdata == nullptr) ? 0 : image_width; }
-        int height() const { return (fdata == nullptr) ? 0 : image_height; }
+        bool loaded() const { return fdata != nullptr || bdata != nullptr; }
+        bool is_hdr() const { return fdata != nullptr; }
+
+        int width()  const { return loaded() ? image_width : 0; }
+        int height() const { return loaded() ? image_height : 0; }
 
-        const unsigned char* pixel_data(int x, int y) const {
-            // Return the address of the three RGB bytes of the pixel at x,y. If there is no image
-            // data, returns magenta.
-            static unsigned char magenta[] = { 255, 0, 255 };
-            if (bdata == nullptr) return magenta;
+        std::array<float, 3> linear_pixel_data(int x, int y) const {
+            // Return the three linear RGB components of the pixel at x,y, decoding sRGB bytes
+            // through a lookup table. If there is no image data, returns magenta.
+            if (!loaded()) return { 1, 0, 1 };
 
             x = clamp(x, 0, image_width);
             y = clamp(y, 0, image_height);
 
-            return bdata + y*bytes_per_scanline + x*bytes_per_pixel;
+            const auto offset = y*bytes_per_scanline + x*bytes_per_pixel;
+            if (is_hdr()) return { fdata[offset], fdata[offset + 1], fdata[offset + 2] };
+            return texel::decode<TexelFormat::SRGB8>(bdata + offset);
+        }
+
+        static std::string resolve(const std::string& image_filename) {
+            // Return the path of the first likely location holding the image file, or an empty
+            // string if there is none. Locations are only checked for a file, not decoded, and
+            // each file name is searched for once per process however many images share it.
+            static std::mutex mutex;
+            static std::unordered_map<std::string, std::string> resolved;
+
+            std::lock_guard lock(mutex);
+            auto found = resolved.find(image_filename);
+            if (found != resolved.end()) return found->second;
+
+            // Hunt for the image file in some likely locations.
+            std::vector<std::string> candidates;
+            if (auto imagedir = getenv("RTW_IMAGES"))
+                candidates.push_back(std::string(imagedir) + "/" + image_filename);
+            candidates.push_back(image_filename);
+            candidates.push_back("src/images/" + image_filename);
+            auto parent = std::string("images/");
+            for (int level = 0; level <= 6; level++, parent = "../" + parent)
+                candidates.push_back(parent + image_filename);
+
+            std::string path;
+            for (const auto& candidate : candidates) {
+                std::error_code error;
+                if (std::filesystem::is_regular_file(candidate, error)) {
+                    path = candidate;
+                    break;
+                }
+            }
+            return resolved.emplace(image_filename, path).first->second;
         }
 
     private:
         const int      bytes_per_pixel = 3;
-        float         *fdata = nullptr;         // Linear floating point pixel data
-        unsigned char *bdata = nullptr;         // Linear 8-bit pixel data
+        float         *fdata = nullptr;         // Linear floating point pixel data, if HDR
+        unsigned char *bdata = nullptr;         // sRGB-encoded 8-bit pixel data otherwise
         int            image_width = 0;         // Loaded image width
         int            image_height = 0;        // Loaded image height
         int            bytes_per_scanline = 0;
@@ -88,30 +130,6 @@ class rtw_image {
             if (x < high) return x;
             return high - 1;
         }
-
-        static unsigned char float_to_byte(float value) {
-            if (value <= 0.0)
-                return 0;
-            if (1.0 <= value)
-                return 255;
-            return static_cast<unsigned char>(256.0 * value);
-        }
-
-        void convert_to_bytes() {
-            // Convert the linear floating point pixel data to bytes, storing the resulting byte
-            // data in the `bdata` member.
-
-            int total_bytes = image_width * image_height * bytes_per_pixel;
-            bdata = new unsigned char[total_bytes];
-
-            // Iterate through all pixel components, converting from [0.0, 1.0] float values to
-            // unsigned [0, 255] byte values.
-
-            auto *bptr = bdata;
-            auto *fptr = fdata;
-            for (auto i=0; i < total_bytes; i++, fptr++, bptr++)
-                *bptr = float_to_byte(*fptr);
-        }
 };
 
 #endif
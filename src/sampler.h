@@ -42,6 +42,19 @@ public:
         )),
         sampler_factory(cfg.type()) {}
 
+    // Replaces the view, keeping the exposure
+    void set_view(const SamplerData& view) {
+        auto updated { std::make_shared<SamplerData>(view) };
+        updated->exposure = data->exposure;
+        data = updated;
+    }
+
+    void set_exposure(const Exposure& exposure) {
+        auto updated { std::make_shared<SamplerData>(*data) };
+        updated->exposure = exposure;
+        data = updated;
+    }
+
     std::unique_ptr<PixelSampler> pixel(int i, int j) const {
         return sampler_factory(data, cfg, i, j);
     }
@@ -74,6 +74,34 @@ std::ostream& operator<<(std::ostream& os, const SamplerConfig& cfg) {
     return os;
 }
 
+// When the camera's shutter is open. Scene motion is defined over times
+// [0, 1]: a still exposes all of it, while frame k of an n frame animation
+// covers [k / n, (k + 1) / n). The shutter opens and closes at fractions of
+// the frame.
+struct Exposure {
+    double frame_start { 0 };
+    double frame_length { 1 };
+    double shutter_open { 0 };
+    double shutter_close { 1 };
+
+    static Exposure frame(
+        int k, int n, double shutter_open = 0, double shutter_close = 1
+    ) {
+        return Exposure {
+            static_cast<double>(k) / n,
+            1.0 / n,
+            shutter_open,
+            shutter_close
+        };
+    }
+
+    // Time at fraction u of the way through the exposure
+    double time(double u) const {
+        return frame_start + frame_length
+            * (shutter_open + (shutter_close - shutter_open) * u);
+    }
+};
+
 struct SamplerData {
     Point3 origin;
     Point3 pixel00_loc;
@@ -82,6 +110,7 @@ struct SamplerData {
     double defocus_angle;
     Direction3 defocus_disk_u;
     Direction3 defocus_disk_v;
+    Exposure exposure {};
 
     SamplerData() = delete;
     SamplerData(
@@ -94,6 +123,7 @@ struct SamplerData {
         double focus_dist
     ) {
         origin = lookfrom;
+        this->defocus_angle = defocus_angle;
 
         // Viewport dimensions
         const auto theta = degrees_to_radians(vfov);
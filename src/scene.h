@@ -3,6 +3,7 @@
 
 #include <iostream>
 
+#include "arena.h"
 #include "hittable_list.h"
 #include "camera.h"
 #include "sphere.h"
@@ -10,40 +11,79 @@
 #include "bvh.h"
 #include "quad.h"
 #include "texture.h"
+#include "texture_loader.h"
 #include "movement.h"
 #include "constant_medium.h"
+#include "grid_medium.h"
 #include "material.h"
 #include "world.h"
 #include "renderer.h"
 
 class Scene {
     private:
+        // Owns the scene contents, so it is declared first to outlive
+        // everything pointing into it
+        std::shared_ptr<Arena> arena;
         std::shared_ptr<World> world;
         std::shared_ptr<Camera> cam;
 
     public:
         Scene() = default;
+        // Image textures load in the background while the scene is built;
+        // it is only complete once they have finished
         Scene(
+            std::shared_ptr<Arena> arena,
             std::shared_ptr<World> world,
             std::shared_ptr<Camera> cam
-        ) : world(world), cam(cam) {}
+        ) : arena(arena), world(world), cam(cam) {
+            TextureLoader::global().wait();
+        }
+
+        Camera& camera() { return *cam; }
 
-        std::map<RendererType, Image> render() {
-            cam->render(*world);
+        std::map<RendererType, Image> render(
+            ThreadPool& pool,
+            IntegratorType integrator = IntegratorType::Path,
+            const Exposure& exposure = Exposure {}
+        ) {
+            cam->set_exposure(exposure);
+            cam->render(*world, pool, integrator);
             return cam->get_results();
         }
 };
 
+// texture on a static sphere, baked into an image bake_width texels wide
+// and half as high over the sphere's (u, v) when bake_width is positive
+std::shared_ptr<Texture> bake_on_sphere(
+    Arena& arena,
+    std::shared_ptr<Texture> texture,
+    const Point3& center,
+    double radius,
+    int bake_width
+) {
+    if (bake_width <= 0) return texture;
+    return arena.make<BakedTexture>(
+        texture,
+        [center, radius](double u, double v) {
+            return center + radius * Sphere::point_at_uv(u, v);
+        },
+        bake_width,
+        std::max(1, bake_width / 2)
+    );
+}
+
 Scene bouncing_spheres(
     const SamplerConfig& sampler_config,
     const std::vector<RendererType>& renderer_types,
     double ar,
     int image_width
 ) {
+    const auto arena { std::make_shared<Arena>() };
+
     HittableList world;
 
-    auto ground_material = std::make_shared<Lambertian>(Colour(0.5, 0.5, 0.5));
-    world.add(std::make_shared<Sphere>(
+    auto ground_material = arena->make<Lambertian>(Colour(0.5, 0.5, 0.5));
+    world.add(arena->make<Sphere>(
         Point3(0,-1000,0), 1000, ground_material
     ));
 
@@ -62,26 +102,26 @@ Scene bouncing_spheres(
                 if (choose_mat < 0.8) {
                     // diffuse
                     auto albedo = Colour::random() * Colour::random();
-                    sphere_material = std::make_shared<Lambertian>(albedo);
+                    sphere_material = arena->make<Lambertian>(albedo);
                     auto center2 = center
                         + Direction3(0, gen_rand::random_double(0, 0.5), 0);
 
-                    world.add(std::make_shared<Sphere>(
+                    world.add(arena->make<Sphere>(
                             center, center2, 0.2, sphere_material
                     ));
                 } else if (choose_mat < 0.95) {
                     // Metal
                     auto albedo = Colour::random(0.5, 1);
                     auto fuzz = gen_rand::random_double(0, 0.5);
-                    sphere_material = std::make_shared<Metal>(albedo, fuzz);
+                    sphere_material = arena->make<Metal>(albedo, fuzz);
 
-                    world.add(std::make_shared<Sphere>(
+                    world.add(arena->make<Sphere>(
                         center, 0.2, sphere_material
                     ));
                 } else {
                     // glass
-                    sphere_material = std::make_shared<Dielectric>(1.5);
-                    world.add(std::make_shared<Sphere>(
+                    sphere_material = arena->make<Dielectric>(1.5);
+                    world.add(arena->make<Sphere>(
                         center, 0.2, sphere_material
                     ));
                 }
@@ -89,16 +129,16 @@ Scene bouncing_spheres(
         }
     }
 
-    auto material1 = std::make_shared<Dielectric>(1.5);
-    world.add(std::make_shared<Sphere>(Point3(0, 1, 0), 1.0, material1));
+    auto material1 = arena->make<Dielectric>(1.5);
+    world.add(arena->make<Sphere>(Point3(0, 1, 0), 1.0, material1));
 
-    auto material2 = std::make_shared<Lambertian>(Colour(0.4, 0.2, 0.1));
-    world.add(std::make_shared<Sphere>(Point3(-4, 1, 0), 1.0, material2));
+    auto material2 = arena->make<Lambertian>(Colour(0.4, 0.2, 0.1));
+    world.add(arena->make<Sphere>(Point3(-4, 1, 0), 1.0, material2));
 
-    auto material3 = std::make_shared<Metal>(Colour(0.7, 0.6, 0.5), 0.0);
-    world.add(std::make_shared<Sphere>(Point3(4, 1, 0), 1.0, material3));
+    auto material3 = arena->make<Metal>(Colour(0.7, 0.6, 0.5), 0.0);
+    world.add(arena->make<Sphere>(Point3(4, 1, 0), 1.0, material3));
 
-    world = HittableList(std::make_shared<BVHNode>(world));
+    world = HittableList(arena->make<MotionBVHNode>(world, *arena));
 
     auto cam = std::make_shared<Camera>(
         sampler_config,
@@ -115,6 +155,7 @@ Scene bouncing_spheres(
     );
 
     return Scene(
+        arena,
         std::make_shared<World>(world, Colour(0.7, 0.8, 1.0)),
         cam
     );
@@ -124,20 +165,25 @@ Scene checkered_spheres(
     const SamplerConfig& sampler_config,
     const std::vector<RendererType>& renderer_types,
     double ar,
-    int image_width
+    int image_width,
+    int bake_width = 0
 ) {
+    const auto arena { std::make_shared<Arena>() };
+
     HittableList world;
 
-    const auto checker = std::make_shared<CheckerTexture>(
+    const auto checker = arena->make<CheckerTexture>(
         0.32,
         Colour(0.2, 0.3, 0.1),
         Colour(0.9, 0.9, 0.9)
     );
 
-    const auto sphere_material = std::make_shared<Lambertian>(checker);
-
-    world.add(std::make_shared<Sphere>(Point3(0,-10,0), 10, sphere_material));
-    world.add(std::make_shared<Sphere>(Point3(0,10,0), 10, sphere_material));
+    for (const auto& center : { Point3(0,-10,0), Point3(0,10,0) }) {
+        const auto sphere_material = arena->make<Lambertian>(
+            bake_on_sphere(*arena, checker, center, 10, bake_width)
+        );
+        world.add(arena->make<Sphere>(center, 10, sphere_material));
+    }
 
     auto cam = std::make_shared<Camera>(
         sampler_config,
@@ -152,6 +198,7 @@ Scene checkered_spheres(
     );
 
     return Scene(
+        arena,
         std::make_shared<World>(world, Colour(0.7, 0.8, 1.0)),
         cam
     );
@@ -163,11 +210,13 @@ Scene earth(
     double ar,
     int image_width
 ) {
+    const auto arena { std::make_shared<Arena>() };
+
     HittableList world;
 
-    const auto earth_texture = std::make_shared<ImageTexture>("map.jpg");
-    const auto earth_material = std::make_shared<Lambertian>(earth_texture);
-    const auto globe = std::make_shared<Sphere>(
+    const auto earth_texture = arena->make<ImageTexture>("map.jpg");
+    const auto earth_material = arena->make<Lambertian>(earth_texture);
+    const auto globe = arena->make<Sphere>(
         Point3(0, 0, 0), 2, earth_material
     );
 
@@ -185,6 +234,7 @@ Scene earth(
     );
 
     return Scene(
+        arena,
         std::make_shared<World>(world, Colour(0.7, 0.8, 1.0)),
         cam
     );
@@ -194,18 +244,25 @@ Scene perlin_spheres(
     const SamplerConfig& sampler_config,
     const std::vector<RendererType>& renderer_types,
     double ar,
-    int image_width
+    int image_width,
+    int bake_width = 0
 ) {
+    const auto arena { std::make_shared<Arena>() };
+
     HittableList world;
 
-    const auto pertext = std::make_shared<NoiseTexture>(4);
-    const auto sphere_material = std::make_shared<Lambertian>(pertext);
+    const auto pertext = arena->make<NoiseTexture>(4);
+    const auto sphere_material = arena->make<Lambertian>(pertext);
 
     world.add(
-        std::make_shared<Sphere>(Point3(0, -1000, 0), 1000, sphere_material)
+        arena->make<Sphere>(Point3(0, -1000, 0), 1000, sphere_material)
+    );
+    // The ground is too large to bake
+    const auto small_material = arena->make<Lambertian>(
+        bake_on_sphere(*arena, pertext, Point3(0, 2, 0), 2, bake_width)
     );
     world.add(
-        std::make_shared<Sphere>(Point3(0, 2, 0), 2, sphere_material)
+        arena->make<Sphere>(Point3(0, 2, 0), 2, small_material)
     );
 
     auto cam = std::make_shared<Camera>(
@@ -221,6 +278,7 @@ Scene perlin_spheres(
     );
 
     return Scene(
+        arena,
         std::make_shared<World>(world, Colour(0.7, 0.8, 1.0)),
         cam
     );
@@ -232,29 +290,31 @@ Scene quads(
     double ar,
     int image_width
 ) {
+    const auto arena { std::make_shared<Arena>() };
+
     HittableList world;
 
     // Materials
-    const auto left_red = std::make_shared<Lambertian>(Colour(1, 0.2, 0.2));
-    const auto back_green = std::make_shared<Lambertian>(Colour(0.2, 1, 0.2));
-    const auto right_blue = std::make_shared<Lambertian>(Colour(0.2, 0.2, 1));
-    const auto upper_orange = std::make_shared<Lambertian>(Colour(1, 0.5, 0));
-    const auto lower_teal = std::make_shared<Lambertian>(Colour(0.2, 0.8, 0.8));
+    const auto left_red = arena->make<Lambertian>(Colour(1, 0.2, 0.2));
+    const auto back_green = arena->make<Lambertian>(Colour(0.2, 1, 0.2));
+    const auto right_blue = arena->make<Lambertian>(Colour(0.2, 0.2, 1));
+    const auto upper_orange = arena->make<Lambertian>(Colour(1, 0.5, 0));
+    const auto lower_teal = arena->make<Lambertian>(Colour(0.2, 0.8, 0.8));
 
     // Quads
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(-3, -2, 5), Direction3(0, 0, -4), Direction3(0, 4, 0), left_red
     ));
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(-2, -2, 0), Direction3(4, 0, 0), Direction3(0, 4, 0), right_blue
     ));
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(3, -2, 1), Direction3(0, 0, 4), Direction3(0, 4, 0), back_green
     ));
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(-2, 3, 1), Direction3(4, 0, 0), Direction3(0, 0, 4), upper_orange
     ));
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(-2, -3, 1), Direction3(4, 0, 0), Direction3(0, 0, 4), lower_teal
     ));
 
@@ -270,6 +330,7 @@ Scene quads(
     );
 
     return Scene(
+        arena,
         std::make_shared<World>(world, Colour(0.7, 0.8, 1.0)),
         cam
     );
@@ -281,19 +342,21 @@ Scene triangles(
     double ar,
     int image_width
 ) {
+    const auto arena { std::make_shared<Arena>() };
+
     HittableList world;
 
-    const auto left_red = std::make_shared<Lambertian>(Colour(1, 0.2, 0.2));
-    const auto back_green = std::make_shared<Lambertian>(Colour(0.2, 1, 0.2));
-    const auto right_blue = std::make_shared<Lambertian>(Colour(0.2, 0.2, 1));
+    const auto left_red = arena->make<Lambertian>(Colour(1, 0.2, 0.2));
+    const auto back_green = arena->make<Lambertian>(Colour(0.2, 1, 0.2));
+    const auto right_blue = arena->make<Lambertian>(Colour(0.2, 0.2, 1));
 
-    world.add(std::make_shared<Triangle>(
+    world.add(arena->make<Triangle>(
         Point3(-3, -2, 5), Direction3(0, 0, -4), Direction3(0, 4, 0), left_red
     ));
-    world.add(std::make_shared<Triangle>(
+    world.add(arena->make<Triangle>(
         Point3(-2, -2, 0), Direction3(4, 0, 0), Direction3(0, 4, 0), right_blue
     ));
-    world.add(std::make_shared<Triangle>(
+    world.add(arena->make<Triangle>(
         Point3(3, -2, 1), Direction3(0, 0, 4), Direction3(0, 4, 0), back_green
     ));
 
@@ -309,6 +372,7 @@ Scene triangles(
     );
 
     return Scene(
+        arena,
         std::make_shared<World>(world, Colour(0.7, 0.8, 1.0)),
         cam
     );
@@ -320,25 +384,27 @@ Scene ellipses(
     double ar,
     int image_width
 ) {
+    const auto arena { std::make_shared<Arena>() };
+
     HittableList world;
 
-    const auto ellipse_material = std::make_shared<Lambertian>(
+    const auto ellipse_material = arena->make<Lambertian>(
         Colour(0.8, 0.8, 0.0)
     );
-    world.add(std::make_shared<Ellipse>(
+    world.add(arena->make<Ellipse>(
         Point3(0, 0, 0),
         Direction3(1, 0, 0),
         Direction3(0, 1, 0),
         ellipse_material)
     );
-    world.add(std::make_shared<Ellipse>(
+    world.add(arena->make<Ellipse>(
         Point3(2.5, 0, 0),
         Direction3(1, 0, 0),
         Direction3(0, 2, -1),
         ellipse_material)
     );
 
-    world.add(std::make_shared<Disc>(
+    world.add(arena->make<Disc>(
         Point3(-2.5, 0, 0),
         Direction3(1, 1, 0),
         Direction3(0, 1, 0),
@@ -358,6 +424,7 @@ Scene ellipses(
     );
 
     return Scene(
+        arena,
         std::make_shared<World>(world, Colour(0.7, 0.8, 1.0)),
         cam
     );
@@ -367,22 +434,36 @@ Scene simple_light(
     const SamplerConfig& sampler_config,
     const std::vector<RendererType>& renderer_types,
     double ar,
-    int image_width
+    int image_width,
+    int bake_width = 0
 ) {
+    const auto arena { std::make_shared<Arena>() };
+
     HittableList world;
 
-    const auto pertext = std::make_shared<NoiseTexture>(4);
-    const auto sphere_material = std::make_shared<Lambertian>(pertext);
+    const auto pertext = arena->make<NoiseTexture>(4);
+    const auto sphere_material = arena->make<Lambertian>(pertext);
     world.add(
-        std::make_shared<Sphere>(Point3(0,-1000,0), 1000, sphere_material)
+        arena->make<Sphere>(Point3(0,-1000,0), 1000, sphere_material)
+    );
+    const auto small_material = arena->make<Lambertian>(
+        bake_on_sphere(*arena, pertext, Point3(0,2,0), 2, bake_width)
     );
-    world.add(std::make_shared<Sphere>(Point3(0,2,0), 2, sphere_material));
+    world.add(arena->make<Sphere>(Point3(0,2,0), 2, small_material));
 
-    const auto light = std::make_shared<DiffuseLight>(Colour(4, 4, 4));
-    world.add(std::make_shared<Quad>(
+    const auto light = arena->make<DiffuseLight>(Colour(4, 4, 4));
+    const auto light_quad = arena->make<Quad>(
         Point3(3, 1, -2), Direction3(2, 0, 0), Direction3(0, 2, 0), light
-    ));
-    world.add(std::make_shared<Sphere>(Point3(0, 7, 0), 2, light));
+    );
+    const auto light_sphere = arena->make<Sphere>(
+        Point3(0, 7, 0), 2, light
+    );
+    world.add(light_quad);
+    world.add(light_sphere);
+
+    HittableList lights;
+    lights.add(light_quad);
+    lights.add(light_sphere);
 
     auto cam = std::make_shared<Camera>(
         sampler_config,
@@ -396,7 +477,8 @@ Scene simple_light(
     );
 
     return Scene(
-        std::make_shared<World>(world, Colour(0, 0, 0)),
+        arena,
+        std::make_shared<World>(world, Colour(0, 0, 0), lights),
         cam
     );
 }
@@ -407,49 +489,55 @@ Scene cornell_box(
     double ar,
     int image_width
 ) {
+    const auto arena { std::make_shared<Arena>() };
+
     HittableList world;
 
-    const auto red = std::make_shared<Lambertian>(Colour(0.65, 0.05, 0.05));
-    const auto white = std::make_shared<Lambertian>(Colour(0.73, 0.73, 0.73));
-    const auto green = std::make_shared<Lambertian>(Colour(0.12, 0.45, 0.09));
-    const auto light = std::make_shared<DiffuseLight>(Colour(25, 25, 25));
+    const auto red = arena->make<Lambertian>(Colour(0.65, 0.05, 0.05));
+    const auto white = arena->make<Lambertian>(Colour(0.73, 0.73, 0.73));
+    const auto green = arena->make<Lambertian>(Colour(0.12, 0.45, 0.09));
+    const auto light = arena->make<DiffuseLight>(Colour(25, 25, 25));
 
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(555, 0, 0), Direction3(0, 555, 0), Direction3(0, 0, 555), green
     ));
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(0, 0, 0), Direction3(0, 555, 0), Direction3(0, 0, 555), red
     ));
-    world.add(std::make_shared<Quad>(
+    const auto light_quad = arena->make<Quad>(
         Point3(343, 554, 332),
         Direction3(-130, 0, 0),
         Direction3(0, 0, -105),
         light
-    ));
-    world.add(std::make_shared<Quad>(
+    );
+    world.add(light_quad);
+    world.add(arena->make<Quad>(
         Point3(0, 0, 0), Direction3(555, 0, 0), Direction3(0, 0, 555), white
     ));
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(555,555,555), Direction3(-555,0,0), Direction3(0,0,-555), white
     ));
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(0, 0, 555), Direction3(555, 0, 0), Direction3(0, 555, 0), white
     ));
 
     std::shared_ptr<Hittable> box1 = box(
-        Point3(0,0,0), Point3(165,330,165), white
+        Point3(0,0,0), Point3(165,330,165), white, *arena
     );
-    box1 = std::make_shared<RotateY>(box1, 15);
-    box1 = std::make_shared<Translate>(box1, Direction3(265,0,295));
+    box1 = arena->make<RotateY>(box1, 15);
+    box1 = arena->make<Translate>(box1, Direction3(265,0,295));
     world.add(box1);
 
     std::shared_ptr<Hittable> box2 = box(
-        Point3(0,0,0), Point3(165,165,165), white
+        Point3(0,0,0), Point3(165,165,165), white, *arena
     );
-    box2 = std::make_shared<RotateY>(box2, -18);
-    box2 = std::make_shared<Translate>(box2, Direction3(130,0,65));
+    box2 = arena->make<RotateY>(box2, -18);
+    box2 = arena->make<Translate>(box2, Direction3(130,0,65));
     world.add(box2);
 
+    HittableList lights;
+    lights.add(light_quad);
+
     auto cam = std::make_shared<Camera>(
         sampler_config,
         renderer_types,
@@ -462,7 +550,8 @@ Scene cornell_box(
     );
 
     return Scene(
-        std::make_shared<World>(world),
+        arena,
+        std::make_shared<World>(world, Colour(1e-3, 1e-3, 1e-3), lights),
         cam
     );
 }
@@ -473,46 +562,52 @@ Scene cornell_smoke(
     double ar,
     int image_width
 ) {
+    const auto arena { std::make_shared<Arena>() };
+
     HittableList world;
 
-    auto red   = std::make_shared<Lambertian>(Colour(.65, .05, .05));
-    auto white = std::make_shared<Lambertian>(Colour(.73, .73, .73));
-    auto green = std::make_shared<Lambertian>(Colour(.12, .45, .15));
-    auto light = std::make_shared<DiffuseLight>(Colour(7, 7, 7));
+    auto red   = arena->make<Lambertian>(Colour(.65, .05, .05));
+    auto white = arena->make<Lambertian>(Colour(.73, .73, .73));
+    auto green = arena->make<Lambertian>(Colour(.12, .45, .15));
+    auto light = arena->make<DiffuseLight>(Colour(7, 7, 7));
 
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(555,0,0), Direction3(0,555,0), Direction3(0,0,555), green
     ));
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(0,0,0), Direction3(0,555,0), Direction3(0,0,555), red
     ));
-    world.add(std::make_shared<Quad>(
+    const auto light_quad = arena->make<Quad>(
         Point3(113,554,127), Direction3(330,0,0), Direction3(0,0,305), light
-    ));
-    world.add(std::make_shared<Quad>(
+    );
+    world.add(light_quad);
+    world.add(arena->make<Quad>(
         Point3(0,555,0), Direction3(555,0,0), Direction3(0,0,555), white
     ));
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(0,0,0), Direction3(555,0,0), Direction3(0,0,555), white
     ));
-    world.add(std::make_shared<Quad>(
+    world.add(arena->make<Quad>(
         Point3(0,0,555), Direction3(555,0,0), Direction3(0,555,0), white
     ));
 
     std::shared_ptr<Hittable> box1 = box(
-        Point3(0,0,0), Point3(165,330,165), white
+        Point3(0,0,0), Point3(165,330,165), white, *arena
     );
-    box1 = std::make_shared<RotateY>(box1, 15);
-    box1 = std::make_shared<Translate>(box1, Direction3(265,0,295));
+    box1 = arena->make<RotateY>(box1, 15);
+    box1 = arena->make<Translate>(box1, Direction3(265,0,295));
 
     std::shared_ptr<Hittable> box2 = box(
-        Point3(0,0,0), Point3(165,165,165), white
+        Point3(0,0,0), Point3(165,165,165), white, *arena
     );
-    box2 = std::make_shared<RotateY>(box2, -18);
-    box2 = std::make_shared<Translate>(box2, Direction3(130,0,65));
+    box2 = arena->make<RotateY>(box2, -18);
+    box2 = arena->make<Translate>(box2, Direction3(130,0,65));
 
-    world.add(std::make_shared<ConstantMedium>(box1, 0.01, Colour(0,0,0)));
-    world.add(std::make_shared<ConstantMedium>(box2, 0.01, Colour(1,1,1)));
+    world.add(arena->make<ConstantMedium>(box1, 0.01, Colour(0,0,0)));
+    world.add(arena->make<ConstantMedium>(box2, 0.01, Colour(1,1,1)));
+
+    HittableList lights;
+    lights.add(light_quad);
 
     auto cam = std::make_shared<Camera>(
         sampler_config,
@@ -526,7 +621,8 @@ Scene cornell_smoke(
     );
 
     return Scene(
-        std::make_shared<World>(world),
+        arena,
+        std::make_shared<World>(world, Colour(1e-3, 1e-3, 1e-3), lights),
         cam
     );
 }
@@ -535,11 +631,14 @@ Scene final_scene(
     const SamplerConfig& sampler_config,
     const std::vector<RendererType>& renderer_types,
     double ar,
-    int image_width
+    int image_width,
+    int bake_width = 0
 ) {
+    const auto arena { std::make_shared<Arena>() };
+
     // Ground of boxes
     HittableList boxes1;
-    auto ground = std::make_shared<Lambertian>(Colour(0.48, 0.83, 0.53));
+    auto ground = arena->make<Lambertian>(Colour(0.48, 0.83, 0.53));
     int boxes_per_side = 20;
     for (int i = 0; i < boxes_per_side; i++) {
         for (int j = 0; j < boxes_per_side; j++) {
@@ -551,79 +650,87 @@ Scene final_scene(
             auto y1 = gen_rand::random_double(1,101);
             auto z1 = z0 + w;
 
-            boxes1.add(box(Point3(x0,y0,z0), Point3(x1,y1,z1), ground));
+            boxes1.add(box(
+                Point3(x0,y0,z0), Point3(x1,y1,z1), ground, *arena
+            ));
         }
     }
 
     HittableList world;
 
     // Bounding volume hierarchy for the boxes
-    world.add(std::make_shared<BVHNode>(boxes1));
+    world.add(arena->make<BVHNode>(boxes1, *arena));
 
     // Light
-    auto light = std::make_shared<DiffuseLight>(Colour(7, 7, 7));
-    world.add(std::make_shared<Quad>(
+    auto light = arena->make<DiffuseLight>(Colour(7, 7, 7));
+    const auto light_quad = arena->make<Quad>(
         Point3(123,554,147), Direction3(300,0,0), Direction3(0,0,265), light
-    ));
+    );
+    world.add(light_quad);
+
+    HittableList lights;
+    lights.add(light_quad);
 
     // Moving Sphere
     auto center1 = Point3(400, 400, 200);
     auto center2 = center1 + Direction3(30,0,0);
-    auto sphere_material = std::make_shared<Lambertian>(Colour(0.7, 0.3, 0.1));
-    world.add(std::make_shared<Sphere>(center1, center2, 50, sphere_material));
+    auto sphere_material = arena->make<Lambertian>(Colour(0.7, 0.3, 0.1));
+    world.add(arena->make<Sphere>(center1, center2, 50, sphere_material));
 
     // Static spheres
-    const auto dielectric_material = std::make_shared<Dielectric>(1.5);
-    const auto metal_material = std::make_shared<Metal>(
+    const auto dielectric_material = arena->make<Dielectric>(1.5);
+    const auto metal_material = arena->make<Metal>(
         Colour(0.8, 0.8, 0.9), 1.0
     );
-    world.add(std::make_shared<Sphere>(
+    world.add(arena->make<Sphere>(
         Point3(260, 150, 45), 50, dielectric_material
     ));
-    world.add(std::make_shared<Sphere>(
+    world.add(arena->make<Sphere>(
         Point3(0, 150, 145), 50, metal_material
     ));
 
     // SSR Sphere
-    auto boundary = std::make_shared<Sphere>(
+    auto boundary = arena->make<Sphere>(
         Point3(360,150,145), 70, dielectric_material
     );
     world.add(boundary);
-    world.add(std::make_shared<ConstantMedium>(
+    world.add(arena->make<ConstantMedium>(
         boundary, 0.2, Colour(0.2, 0.4, 0.9)
     ));
-    boundary = std::make_shared<Sphere>(
+    boundary = arena->make<Sphere>(
         Point3(0,0,0), 5000, dielectric_material
     );
-    world.add(std::make_shared<ConstantMedium>(
+    world.add(arena->make<ConstantMedium>(
         boundary, .0001, Colour(1,1,1)
     ));
 
     // World Sphere
-    auto map = std::make_shared<Lambertian>(std::make_shared<ImageTexture>(
+    auto map = arena->make<Lambertian>(arena->make<ImageTexture>(
         "map.jpg"
     ));
-    world.add(std::make_shared<Sphere>(Point3(400,200,400), 100, map));
+    world.add(arena->make<Sphere>(Point3(400,200,400), 100, map));
 
     // Perlin Sphere
-    const auto pertext = std::make_shared<NoiseTexture>(0.2);
-    const auto pertext_material = std::make_shared<Lambertian>(pertext);
-    world.add(std::make_shared<Sphere>(
+    const auto pertext = arena->make<NoiseTexture>(0.2);
+    const auto pertext_material = arena->make<Lambertian>(bake_on_sphere(
+        *arena, pertext, Point3(220,280,300), 80, bake_width
+    ));
+    world.add(arena->make<Sphere>(
         Point3(220,280,300), 80, pertext_material
     ));
 
     // Box of spheres
     HittableList boxes2;
-    const auto white = std::make_shared<Lambertian>(Colour(.73, .73, .73));
+    const auto white = arena->make<Lambertian>(Colour(.73, .73, .73));
     int ns = 1000;
     for (int j = 0; j < ns; j++) {
-        boxes2.add(std::make_shared<Sphere>(Point3::random(0,165), 10, white));
+        boxes2.add(arena->make<Sphere>(Point3::random(0,165), 10, white));
     }
 
     // Bounding volume hierarchy for the box of spheres
-    world.add(std::make_shared<Translate>(
-        std::make_shared<RotateY>(
-            std::make_shared<BVHNode>(boxes2), 15),
+    world.add(arena->make<Translate>(
+        arena->make<RotateY>(
+            arena->make<BVHNode>(boxes2, *arena), 15),
             Direction3(-100,270,395)
         )
     );
@@ -640,7 +747,204 @@ Scene final_scene(
     );
 
     return Scene(
-        std::make_shared<World>(world),
+        arena,
+        std::make_shared<World>(world, Colour(1e-3, 1e-3, 1e-3), lights),
+        cam
+    );
+}
+
+Scene instanced_forest(
+    const SamplerConfig& sampler_config,
+    const std::vector<RendererType>& renderer_types,
+    double ar,
+    int image_width
+) {
+    const auto arena { std::make_shared<Arena>() };
+
+    HittableList world;
+
+    const auto grass = arena->make<Lambertian>(Colour(0.3, 0.45, 0.15));
+    world.add(arena->make<Quad>(
+        Point3(-1000, 0, -1000),
+        Direction3(2000, 0, 0),
+        Direction3(0, 0, 2000),
+        grass
+    ));
+
+    // Unique geometry: each model gets its own BVH, built once
+    const auto bark = arena->make<Lambertian>(Colour(0.35, 0.2, 0.1));
+    const auto leaves = arena->make<Lambertian>(Colour(0.1, 0.4, 0.1));
+    HittableList tree_parts;
+    tree_parts.add(box(
+        Point3(-0.15, 0, -0.15), Point3(0.15, 1.2, 0.15), bark, *arena
+    ));
+    tree_parts.add(arena->make<Sphere>(Point3(0, 1.6, 0), 0.7, leaves));
+    tree_parts.add(arena->make<Sphere>(Point3(0.3, 2.2, 0.1), 0.5, leaves));
+    tree_parts.add(arena->make<Sphere>(Point3(-0.2, 2.6, -0.1), 0.35, leaves));
+    const auto tree { arena->make<BVHNode>(tree_parts, *arena) };
+
+    const auto stone = arena->make<Lambertian>(Colour(0.5, 0.5, 0.5));
+    const auto rock { arena->make<Sphere>(Point3(0, 0, 0), 1, stone) };
+
+    // Thousands of instances of those models, under a BVH of their own
+    HittableList instances;
+    const int trees_per_side { 50 };
+    const double spacing { 3 };
+    for (int i = 0; i < trees_per_side; i++) {
+        for (int j = 0; j < trees_per_side; j++) {
+            const auto x {
+                (i - trees_per_side / 2 + gen_rand::random_double(-0.4, 0.4))
+                    * spacing
+            };
+            const auto z {
+                (j - trees_per_side / 2 + gen_rand::random_double(-0.4, 0.4))
+                    * spacing
+            };
+            const auto lean { Direction3(
+                gen_rand::random_double(-1, 1),
+                0,
+                gen_rand::random_double(-1, 1)
+            ) };
+            const auto transform {
+                Affine::translation(Direction3(x, 0, z))
+                * Affine::rotation(lean, gen_rand::random_double(0, 8))
+                * Affine::rotation(
+                    Direction3(0, 1, 0), gen_rand::random_double(0, 360)
+                )
+                * Affine::scaling(gen_rand::random_double(0.6, 1.4))
+            };
+            instances.add(arena->make<Instance>(tree, transform));
+        }
+    }
+    for (int i = 0; i < 500; i++) {
+        const auto transform {
+            Affine::translation(Direction3(
+                gen_rand::random_double(-75, 75),
+                0,
+                gen_rand::random_double(-75, 75)
+            ))
+            * Affine::rotation(
+                Direction3(0, 1, 0), gen_rand::random_double(0, 360)
+            )
+            * Affine::scaling(
+                gen_rand::random_double(0.3, 0.6),
+                gen_rand::random_double(0.15, 0.3),
+                gen_rand::random_double(0.3, 0.6)
+            )
+        };
+        instances.add(arena->make<Instance>(rock, transform));
+    }
+    // Boulders rolling through the front of the forest, blurred
+    // by their motion over the shutter interval
+    for (int i = 0; i < 12; i++) {
+        const auto radius { gen_rand::random_double(0.4, 0.8) };
+        const auto roll { gen_rand::random_double(1, 3) };
+        const auto transform {
+            Affine::translation(Direction3(
+                gen_rand::random_double(-20, 20),
+                radius,
+                gen_rand::random_double(35, 50)
+            ))
+            * Affine::scaling(radius)
+        };
+        instances.add(arena->make<MotionInstance>(
+            rock,
+            transform,
+            Direction3(roll, 0, 0),
+            Direction3(0, 0, 1),
+            -roll / radius * 180 / pi
+        ));
+    }
+    world.add(arena->make<BVHNode>(instances, *arena));
+
+    auto cam = std::make_shared<Camera>(
+        sampler_config,
+        renderer_types,
+        ar,
+        image_width,
+        20,
+        30,
+        Point3(0, 12, 90),
+        Point3(0, 0, 0)
+    );
+
+    return Scene(
+        arena,
+        std::make_shared<World>(world, Colour(0.7, 0.8, 1.0)),
+        cam
+    );
+}
+
+Scene cornell_cloud(
+    const SamplerConfig& sampler_config,
+    const std::vector<RendererType>& renderer_types,
+    double ar,
+    int image_width
+) {
+    const auto arena { std::make_shared<Arena>() };
+
+    HittableList world;
+
+    auto red   = arena->make<Lambertian>(Colour(.65, .05, .05));
+    auto white = arena->make<Lambertian>(Colour(.73, .73, .73));
+    auto green = arena->make<Lambertian>(Colour(.12, .45, .15));
+    auto light = arena->make<DiffuseLight>(Colour(15, 15, 15));
+
+    world.add(arena->make<Quad>(
+        Point3(555,0,0), Direction3(0,555,0), Direction3(0,0,555), green
+    ));
+    world.add(arena->make<Quad>(
+        Point3(0,0,0), Direction3(0,555,0), Direction3(0,0,555), red
+    ));
+    const auto light_quad = arena->make<Quad>(
+        Point3(343,554,332), Direction3(-130,0,0), Direction3(0,0,-105), light
+    );
+    world.add(light_quad);
+    world.add(arena->make<Quad>(
+        Point3(0,555,0), Direction3(555,0,0), Direction3(0,0,555), white
+    ));
+    world.add(arena->make<Quad>(
+        Point3(0,0,0), Direction3(555,0,0), Direction3(0,0,555), white
+    ));
+    world.add(arena->make<Quad>(
+        Point3(0,0,555), Direction3(555,0,0), Direction3(0,555,0), white
+    ));
+
+    // A cloud: a ball whose edge is pushed in and out by turbulence, dense
+    // inside and fading out over a short distance, so that it has billows
+    // and clear gaps rather than the hard edge of a constant medium
+    const Point3 centre { 278, 250, 278 };
+    const double radius { 160 };
+    const auto& noise { Perlin::shared() };
+    const auto cloud_density { [=, &noise](const Point3& p) {
+        const auto falloff { 1 - (p - centre).length() / radius };
+        const auto billows { noise.turb(p * 0.015, 5) };
+        return 0.05 * std::clamp(4 * (falloff + 1.5 * billows - 0.5), 0.0, 1.0);
+    } };
+    world.add(arena->make<GridMedium>(
+        AABB { centre - radius, centre + radius },
+        std::array<int, 3> { 96, 96, 96 },
+        cloud_density,
+        arena->make<Isotropic>(Colour(0.9, 0.9, 0.9))
+    ));
+
+    HittableList lights;
+    lights.add(light_quad);
+
+    auto cam = std::make_shared<Camera>(
+        sampler_config,
+        renderer_types,
+        ar,
+        image_width,
+        50,
+        40,
+        Point3(278, 278, -800),
+        Point3(278, 278, 0)
+    );
+
+    return Scene(
+        arena,
+        std::make_shared<World>(world, Colour(0, 0, 0), lights),
         cam
     );
 }
@@ -0,0 +1,103 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "concepts.h"
+
+// Four lane vectors of T. With GCC and Clang, float lanes are the
+// compilers' generic vector extensions, which lower to SSE on x86 and NEON
+// on ARM. Double lanes are one only where AVX holds four doubles in a
+// register: elsewhere the vector would be split into pairs and passed in
+// memory, with a different calling convention than AVX builds use.
+// Otherwise, or with RAYTRACER_NO_SIMD, a plain array with the same
+// operators stands in.
+namespace simd {
+
+template <Arithmetic T>
+struct alignas(4 * sizeof(T)) ArrayLanes {
+    T v[4];
+
+    T operator[](int i) const { return v[i]; }
+    T& operator[](int i) { return v[i]; }
+
+    ArrayLanes operator-() const {
+        return ArrayLanes { -v[0], -v[1], -v[2], -v[3] };
+    }
+};
+
+template <Arithmetic T>
+inline ArrayLanes<T> operator+(
+    const ArrayLanes<T>& a, const ArrayLanes<T>& b
+) {
+    return ArrayLanes<T> {
+        a[0] + b[0], a[1] + b[1], a[2] + b[2], a[3] + b[3]
+    };
+}
+
+template <Arithmetic T>
+inline ArrayLanes<T> operator-(
+    const ArrayLanes<T>& a, const ArrayLanes<T>& b
+) {
+    return ArrayLanes<T> {
+        a[0] - b[0], a[1] - b[1], a[2] - b[2], a[3] - b[3]
+    };
+}
+
+template <Arithmetic T>
+inline ArrayLanes<T> operator*(
+    const ArrayLanes<T>& a, const ArrayLanes<T>& b
+) {
+    return ArrayLanes<T> {
+        a[0] * b[0], a[1] * b[1], a[2] * b[2], a[3] * b[3]
+    };
+}
+
+template <Arithmetic T>
+struct Native {
+    using type = ArrayLanes<T>;
+};
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(RAYTRACER_NO_SIMD)
+
+template <>
+struct Native<float> {
+    typedef float type __attribute__((vector_size(4 * sizeof(float))));
+};
+
+#ifdef __AVX__
+
+template <>
+struct Native<double> {
+    typedef double type __attribute__((vector_size(4 * sizeof(double))));
+};
+
+#endif
+
+#endif
+
+template <Arithmetic T>
+using Lanes = typename Native<T>::type;
+
+template <Arithmetic T>
+inline Lanes<T> broadcast(T s) {
+    return Lanes<T> { s, s, s, s };
+}
+
+// (x, y, z, w) -> (y, z, x, w), a single permute
+template <typename L>
+inline L yzx(const L& a) {
+    if constexpr (requires { __builtin_shufflevector(a, a, 1, 2, 0, 3); }) {
+        return __builtin_shufflevector(a, a, 1, 2, 0, 3);
+    } else {
+        return L { a[1], a[2], a[0], a[3] };
+    }
+}
+
+// Horizontal sum of the first three lanes; the fourth is padding
+template <typename L>
+inline auto sum3(const L& a) {
+    return a[0] + a[1] + a[2];
+}
+
+}
+
+#endif
@@ -7,12 +7,13 @@
 #include "ray.h"
 #include "hittable.h"
 #include "material.h"
+#include "onb.h"
 #include "raytracing.h"
 
 class Sphere : public Hittable {
     private:
         Ray cent;
-        double rad;
+        Real rad;
         std::shared_ptr<Material> mat;
         AABB bbox;
 
@@ -24,14 +25,52 @@ class Sphere : public Hittable {
             v = theta / pi;
         }
 
+        // Derivatives of the surface point with respect to the (u, v) of
+        // get_sphere_uv at the point p on the unit sphere, scaled to radius
+        void get_sphere_derivatives(
+            const Point3& p, Direction3& dpdu, Direction3& dpdv
+        ) const {
+            const auto sin_theta {
+                std::sqrt(std::fmax(Real(0), p.x() * p.x() + p.z() * p.z()))
+            };
+            dpdu = 2 * pi * rad * Direction3 { p.z(), 0, -p.x() };
+            if (sin_theta <= 0) {
+                dpdv = Direction3 { 0, 0, 0 };
+                return;
+            }
+            dpdv = pi * rad * Direction3 {
+                -p.x() * p.y() / sin_theta,
+                sin_theta,
+                -p.y() * p.z() / sin_theta
+            };
+        }
+
+        // Direction within the cone subtended by a sphere of the given radius
+        // at the given squared distance, about the +z axis
+        static Direction3 random_to_sphere(
+            double radius, double distance_squared
+        ) {
+            const auto r1 { gen_rand::random_double() };
+            const auto r2 { gen_rand::random_double() };
+            const auto cos_theta_max {
+                std::sqrt(1 - radius * radius / distance_squared)
+            };
+            const auto z { 1 + r2 * (cos_theta_max - 1) };
+            const auto phi { 2 * pi * r1 };
+            const auto sin_theta { std::sqrt(1 - z * z) };
+            return Direction3 { Vec3<double> {
+                std::cos(phi) * sin_theta, std::sin(phi) * sin_theta, z
+            } };
+        }
+
     public:
         // Stationary Sphere
         Sphere(
             const Point3& center,
-            double radius,
+            Real radius,
             std::shared_ptr<Material> m
         ) : cent { center, Direction3 { 0, 0, 0 } },
-            rad{ std::fmax(radius, 0) },
+            rad{ std::fmax(radius, Real(0)) },
             mat{ m },
             bbox { center - radius, center + radius }
         {}
@@ -40,10 +79,10 @@ class Sphere : public Hittable {
         Sphere(
             const Point3& center0,
             const Point3& center1,
-            double radius,
+            Real radius,
             std::shared_ptr<Material> m
         ) : cent { center0, center1 - center0 },
-            rad{ std::fmax(radius, 0) },
+            rad{ std::fmax(radius, Real(0)) },
             mat{ m },
             bbox {
                 AABB{ center0 - radius, center0 + radius },
@@ -51,15 +90,27 @@ class Sphere : public Hittable {
             }
         {}
 
+        // Point on the unit sphere at (u, v), inverting get_sphere_uv
+        static Point3 point_at_uv(double u, double v) {
+            const auto theta { v * pi };
+            const auto phi { u * 2 * pi };
+            return Point3 { Vec3<double> {
+                -std::cos(phi) * std::sin(theta),
+                -std::cos(theta),
+                std::sin(phi) * std::sin(theta)
+            } };
+        }
+
         const Ray& center() const { return cent; }
-        double radius() const { return rad; }
+        Real radius() const { return rad; }
 
-        bool hit(
+        // Nearest root of the Ray-Sphere quadratic within t, if any
+        bool intersect(
             const Ray& r,
-            IntervalD t,
-            HitRecord& rec
-        ) const override {
-            const auto current_center = center().at(r.time());
+            IntervalR t,
+            const Point3& current_center,
+            Real& root
+        ) const {
             // Ray-Sphere interaction quantities
             const Direction3 oc { r.origin() - current_center };
             const auto a { r.direction().length_squared() };
@@ -74,25 +125,108 @@ class Sphere : public Hittable {
             const auto sqrtd { std::sqrt(discriminant) };
 
             // Determine which (if any) root is valid by the t-Interval
-            auto root { (-h - sqrtd) / a };
+            root = (-h - sqrtd) / a;
             if (!t.surrounds(root)) {
                 root = (-h + sqrtd) / a;
                 if (!t.surrounds(root)) {
                     return false;
                 }
             }
+            return true;
+        }
+
+        bool hit(
+            const Ray& r,
+            IntervalR t,
+            HitRecord& rec
+        ) const override {
+            Real root {};
+            if (!intersect(r, t, center().at(r.time()), root)) {
+                return false;
+            }
 
-            // Set hit record
             rec.t = root;
-            rec.p = r.at(root);
+            rec.object = this;
+            return true;
+        }
+
+        void surface_interaction(
+            const Ray& r, HitRecord& rec
+        ) const override {
+            const auto current_center = center().at(r.time());
+            rec.p = r.at(rec.t);
             const auto outward_normal { (rec.p - current_center) / radius() };
             rec.set_face_normal(r, outward_normal);
-            rec.mat = mat;
+            rec.mat = mat.get();
             get_sphere_uv(outward_normal, rec.u, rec.v);
+            get_sphere_derivatives(outward_normal, rec.dpdu, rec.dpdv);
+        }
+
+        bool occluded(const Ray& r, IntervalR t) const override {
+            Real root {};
+            return intersect(r, t, center().at(r.time()), root);
+        }
+
+        // Both roots of the quadratic at once
+        bool span(const Ray& r, IntervalR& t) const override {
+            const Direction3 oc { r.origin() - center().at(r.time()) };
+            const auto a { r.direction().length_squared() };
+            const auto h { dot(r.direction(), oc) };
+            const auto c { oc.length_squared() - radius() * radius() };
+
+            const auto discriminant { h * h - a * c };
+            if (discriminant < 0) return false;
+            const auto sqrtd { std::sqrt(discriminant) };
+
+            const auto entry { (-h - sqrtd) / a };
+            const auto exit { (-h + sqrtd) / a };
+            const IntervalR inside {
+                entry < t.min() ? t.min() : entry,
+                exit > t.max() ? t.max() : exit
+            };
+            if (inside.min() >= inside.max()) return false;
+            t = inside;
             return true;
         }
 
         AABB bounding_box() const override { return bbox; }
+
+        MotionAABB motion_bounding_box() const override {
+            return MotionAABB {
+                AABB { cent.at(0) - rad, cent.at(0) + rad },
+                AABB { cent.at(1) - rad, cent.at(1) + rad }
+            };
+        }
+
+        // Light sampling treats the sphere as stationary at its time 0 centre
+        double pdf_value(
+            const Point3& origin, const Direction3& direction
+        ) const override {
+            if (!occluded(
+                Ray { origin, direction }, IntervalR { 0.001, infinity_r }
+            )) return 0;
+
+            const auto distance_squared {
+                (center().origin() - origin).length_squared()
+            };
+            if (distance_squared <= radius() * radius()) return 1 / (4 * pi);
+
+            const auto cos_theta_max {
+                std::sqrt(1 - radius() * radius() / distance_squared)
+            };
+            const auto solid_angle { 2 * pi * (1 - cos_theta_max) };
+            return 1 / solid_angle;
+        }
+
+        Direction3 random(const Point3& origin) const override {
+            const auto direction { center().origin() - origin };
+            const auto distance_squared { direction.length_squared() };
+            if (distance_squared <= radius() * radius()) {
+                return random_unit_vector();
+            }
+            const ONB uvw { direction };
+            return uvw.transform(random_to_sphere(radius(), distance_squared));
+        }
 };
 
 #endif
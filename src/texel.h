@@ -0,0 +1,184 @@
+#ifndef TEXEL_H
+#define TEXEL_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// How a texture stores its RGB texels. Ordinary 8-bit images keep their
+// sRGB-encoded bytes, decoded to linear through a table on lookup. High
+// dynamic range images keep linear half floats.
+enum class TexelFormat {
+    SRGB8,
+    Half
+};
+
+namespace texel {
+    constexpr int bytes(TexelFormat format) {
+        return format == TexelFormat::SRGB8 ? 3 : 6;
+    }
+
+    inline float srgb_to_linear(float encoded) {
+        return encoded <= 0.04045f
+            ? encoded / 12.92f
+            : std::pow((encoded + 0.055f) / 1.055f, 2.4f);
+    }
+
+    inline float linear_to_srgb(float linear) {
+        return linear <= 0.0031308f
+            ? linear * 12.92f
+            : 1.055f * std::pow(linear, 1 / 2.4f) - 0.055f;
+    }
+
+    // Linear value of each sRGB byte
+    inline const std::array<float, 256> srgb_table { [] {
+        std::array<float, 256> table {};
+        for (int i = 0; i < 256; i++) {
+            table[i] = srgb_to_linear(i / 255.0f);
+        }
+        return table;
+    }() };
+
+    // Linear values halfway, in sRGB, between consecutive bytes
+    inline const std::array<float, 255> srgb_thresholds { [] {
+        std::array<float, 255> thresholds {};
+        for (int i = 0; i < 255; i++) {
+            thresholds[i] = srgb_to_linear((i + 0.5f) / 255);
+        }
+        return thresholds;
+    }() };
+
+    // Linear [0, 1] split into equal buckets, each mapped to the sRGB byte
+    // nearest its start. They are narrow enough that a value is at most a
+    // byte or two past its bucket's.
+    inline constexpr int srgb_buckets { 4096 };
+    inline const std::array<unsigned char, srgb_buckets> srgb_bucket_bytes {
+        [] {
+            std::array<unsigned char, srgb_buckets> bytes {};
+            for (int i = 0; i < srgb_buckets; i++) {
+                const auto above { std::upper_bound(
+                    srgb_thresholds.begin(),
+                    srgb_thresholds.end(),
+                    static_cast<float>(i) / srgb_buckets
+                ) };
+                bytes[i] = static_cast<unsigned char>(
+                    above - srgb_thresholds.begin()
+                );
+            }
+            return bytes;
+        }()
+    };
+
+    // Nearest sRGB byte, from the tables rather than raising to a power
+    // for every texel of every level
+    inline unsigned char encode_srgb(float linear) {
+        if (!(linear > 0)) return 0;
+        if (linear >= 1) return 255;
+        auto encoded {
+            srgb_bucket_bytes[static_cast<int>(linear * srgb_buckets)]
+        };
+        while (encoded < 255 && linear >= srgb_thresholds[encoded]) {
+            encoded++;
+        }
+        return encoded;
+    }
+
+    // IEEE binary16, rounding to nearest even. Values beyond its range
+    // become infinity.
+    inline std::uint16_t float_to_half(float value) {
+        std::uint32_t bits {};
+        std::memcpy(&bits, &value, sizeof(bits));
+        const std::uint32_t sign { (bits >> 16) & 0x8000 };
+        const auto biased { static_cast<int>((bits >> 23) & 0xff) };
+        auto mantissa { bits & 0x7fffff };
+
+        if (biased == 0xff) {
+            // Infinity stays infinity and NaN stays NaN
+            return static_cast<std::uint16_t>(
+                sign | 0x7c00 | (mantissa ? 0x200 : 0)
+            );
+        }
+
+        // Shift the mantissa into place, below the normal range by as much
+        // as the value is subnormal in half precision
+        auto exponent { biased - 127 + 15 };
+        auto shift { 13 };
+        if (exponent <= 0) {
+            if (exponent < -10) return static_cast<std::uint16_t>(sign);
+            mantissa |= 0x800000;
+            shift += 1 - exponent;
+            exponent = 0;
+        }
+        if (exponent >= 31) return static_cast<std::uint16_t>(sign | 0x7c00);
+
+        auto half {
+            (static_cast<std::uint32_t>(exponent) << 10) | (mantissa >> shift)
+        };
+        // A carry out of the mantissa bumps the exponent, which is still
+        // the correctly rounded result
+        const auto rest { mantissa & ((1u << shift) - 1) };
+        const auto halfway { 1u << (shift - 1) };
+        if (rest > halfway || (rest == halfway && (half & 1))) half++;
+        return static_cast<std::uint16_t>(
+            sign | std::min<std::uint32_t>(half, 0x7c00)
+        );
+    }
+
+    inline float half_to_float(std::uint16_t half) {
+        const auto sign { static_cast<std::uint32_t>(half & 0x8000) << 16 };
+        const auto exponent { (half >> 10) & 0x1f };
+        const auto mantissa { static_cast<std::uint32_t>(half & 0x3ff) };
+
+        if (exponent == 0) {
+            // Zero, or a subnormal scaled by 2^-24
+            const auto value {
+                std::ldexp(static_cast<float>(mantissa), -24)
+            };
+            return sign ? -value : value;
+        }
+
+        std::uint32_t bits {};
+        if (exponent == 31) {
+            bits = sign | 0x7f800000 | (mantissa << 13);
+        } else {
+            bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+        }
+        float value {};
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Linear RGB of the texel stored at p
+    template <TexelFormat F>
+    std::array<float, 3> decode(const unsigned char* p) {
+        if constexpr (F == TexelFormat::SRGB8) {
+            return { srgb_table[p[0]], srgb_table[p[1]], srgb_table[p[2]] };
+        } else {
+            std::uint16_t h[3] {};
+            std::memcpy(h, p, sizeof(h));
+            return {
+                half_to_float(h[0]), half_to_float(h[1]), half_to_float(h[2])
+            };
+        }
+    }
+
+    // Stores linear RGB as a texel at p
+    inline void encode(
+        TexelFormat format, const float* rgb, unsigned char* p
+    ) {
+        if (format == TexelFormat::SRGB8) {
+            for (int c = 0; c < 3; c++) {
+                p[c] = encode_srgb(rgb[c]);
+            }
+            return;
+        }
+        const std::uint16_t h[3] {
+            float_to_half(rgb[0]), float_to_half(rgb[1]), float_to_half(rgb[2])
+        };
+        std::memcpy(p, h, sizeof(h));
+    }
+}
+
+#endif
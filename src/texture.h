@@ -1,18 +1,37 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include <functional>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "vec3.h"
 #include "colour.h"
+#include "footprint.h"
+#include "mipmap.h"
 #include "rtw_stb_image.h"
 #include "perlin.h"
+#include "texel.h"
+#include "texture_loader.h"
+#include "texture_registry.h"
 
 class Texture {
     public:
         virtual ~Texture() = default;
 
         virtual Colour value(double u, double v, const Point3& p) const = 0;
+
+        // Value averaged over the footprint around (u, v). Textures without
+        // detail to alias fall back to the point lookup.
+        virtual Colour value(
+            double u,
+            double v,
+            const Point3& p,
+            const TextureFootprint& footprint
+        ) const {
+            return value(u, v, p);
+        }
 };
 
 class SolidColour : public Texture {
@@ -58,45 +77,71 @@ class CheckerTexture : public Texture {
             ) {}
 
         Colour value(double u, double v, const Point3& p) const override {
+            return value(u, v, p, TextureFootprint {});
+        }
+
+        Colour value(
+            double u,
+            double v,
+            const Point3& p,
+            const TextureFootprint& footprint
+        ) const override {
             const auto x { static_cast<int>(std::floor(inv_scale * p.x())) };
             const auto y { static_cast<int>(std::floor(inv_scale * p.y())) };
             const auto z { static_cast<int>(std::floor(inv_scale * p.z())) };
 
             const bool is_even { (x + y + z) % 2 == 0 };
-            return is_even ? even->value(u, v, p) : odd->value(u, v, p);
+            return is_even
+                ? even->value(u, v, p, footprint)
+                : odd->value(u, v, p, footprint);
         }
 };
 
-class ImageTexture : public Texture {
+// Texture looked up in a mip pyramid over (u, v). The pyramid is built by a
+// job on the texture loader, and is ready once the loader has been waited
+// on, as every Scene does before rendering.
+class MipMapTexture : public Texture {
     private:
-        const rtw_image img;
+        const TextureRegistry::Handle image;
 
-    public:
-        ImageTexture() = delete;
-        explicit ImageTexture(const char* filename) : img { filename } {}
+    protected:
+        explicit MipMapTexture(TextureRegistry::Handle image)
+            : image { image } {}
 
+    public:
         Colour value(double u, double v, const Point3& p) const override {
-            if (img.height() <= 0) return Colour(0, 1, 1);
+            return value(u, v, p, TextureFootprint {});
+        }
+
+        Colour value(
+            double u,
+            double v,
+            const Point3& p,
+            const TextureFootprint& footprint
+        ) const override {
+            const auto* mip { image->mip.get() };
+            if (!mip || mip->height() <= 0) return Colour(0, 1, 1);
 
             u = IntervalD(0, 1).clamp(u);
             v = 1.0 - IntervalD(0, 1).clamp(v); // Flip V to image coordinates
 
-            const auto i { static_cast<int>(u * img.width()) };
-            const auto j { static_cast<int>(v * img.height()) };
-            const auto pixel { img.pixel_data(i, j) };
-
-            const auto colour_scale { 1.0 / 255.0 };
-            return Colour {
-                pixel[0] * colour_scale,
-                pixel[1] * colour_scale,
-                pixel[2] * colour_scale
-            };
+            return mip->lookup(u, v, footprint);
         }
 };
 
+// Image filtered through a mip pyramid, built when the file is loaded. The
+// decoded image itself is only needed for that and is not kept. Textures of
+// the same file share the pyramid through the texture registry.
+class ImageTexture : public MipMapTexture {
+    public:
+        ImageTexture() = delete;
+        explicit ImageTexture(const char* filename)
+            : MipMapTexture { TextureRegistry::global().image(filename) } {}
+};
+
 class NoiseTexture : public Texture {
     private:
-        const Perlin noise {};
+        const Perlin& noise { Perlin::shared() };
         const double scale;
 
     public:
@@ -109,4 +154,61 @@ class NoiseTexture : public Texture {
         }
 };
 
+// Procedural texture sampled once, at the centre of each texel of a
+// width x height image over (u, v), and then filtered through a mip pyramid
+// like an ImageTexture. This trades the image's memory for evaluating the
+// source on every hit, so it suits static objects with expensive textures.
+// surface gives the point on the object at (u, v), where the source is
+// evaluated. The image is baked on the texture loader while the rest of the
+// scene is built, and stores values clamped to [0, 1].
+class BakedTexture : public MipMapTexture {
+    public:
+        using Surface = std::function<Point3(double u, double v)>;
+
+    private:
+        BakedTexture(
+            std::shared_ptr<TextureRegistry::Image> baked,
+            std::shared_ptr<Texture> source,
+            Surface surface,
+            int width,
+            int height
+        ) : MipMapTexture { baked } {
+            TextureLoader::global().load(
+                [baked, source, surface, width, height] {
+                    std::vector<float> texels(3 * width * height);
+                    auto* out { texels.data() };
+                    for (int y = 0; y < height; y++) {
+                        // The top row is v = 1
+                        const auto v { 1 - (y + 0.5) / height };
+                        for (int x = 0; x < width; x++) {
+                            const auto u { (x + 0.5) / width };
+                            const auto c { source->value(u, v, surface(u, v)) };
+                            *out++ = static_cast<float>(c.x());
+                            *out++ = static_cast<float>(c.y());
+                            *out++ = static_cast<float>(c.z());
+                        }
+                    }
+                    baked->mip = std::make_unique<const MipMap>(
+                        width, height, std::move(texels), TexelFormat::SRGB8
+                    );
+                }
+            );
+        }
+
+    public:
+        BakedTexture() = delete;
+        BakedTexture(
+            std::shared_ptr<Texture> source,
+            Surface surface,
+            int width,
+            int height
+        ) : BakedTexture {
+            std::make_shared<TextureRegistry::Image>(),
+            source,
+            surface,
+            width,
+            height
+        } {}
+};
+
 #endif
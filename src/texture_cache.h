@@ -0,0 +1,288 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// Process-wide store for texture tiles, keeping at most capacity bytes of
+// them in memory. Tiles are evicted least recently used first; the first
+// time a tile is evicted it is written to a scratch file, from which later
+// fetches page it back in. With the default unbounded capacity nothing is
+// ever evicted and the scratch file is never created. The capacity only
+// covers tiles in the cache. Neither the buffers an image is built from
+// while it loads, nor evicted tiles still held by a thread's micro-cache,
+// are counted.
+class TextureCache {
+    public:
+        // Encoded texels, in whichever format the image stores them
+        using Tile = std::vector<unsigned char>;
+        using TilePtr = std::shared_ptr<const Tile>;
+        // Image, level and tile index packed into one key
+        using Key = std::uint64_t;
+
+        struct Stats {
+            std::size_t capacity { 0 };
+            std::size_t resident { 0 };
+            std::size_t peak { 0 };
+            std::size_t fetches { 0 };
+            std::size_t reads { 0 };
+            std::size_t evictions { 0 };
+        };
+
+    private:
+        struct Entry {
+            TilePtr tile {};
+            std::list<Key>::iterator lru {};
+        };
+
+        // Where an evicted tile lives in the scratch file
+        struct Page {
+            long offset { 0 };
+            std::size_t bytes { 0 };
+        };
+
+        // Recently fetched tiles of one thread, looked up without taking
+        // the lock. A tile stays valid while it is held here, even if the
+        // cache has evicted it meanwhile, so up to 64 tiles per thread can
+        // be in memory beyond the capacity. The slots are shared by every
+        // cache the thread fetches from, so each names the cache it holds a
+        // tile of.
+        struct MicroCache {
+            static constexpr int bits { 6 };
+            struct Slot {
+                // Id of the cache, zero for an empty slot
+                std::uint64_t owner { 0 };
+                Key key { 0 };
+                const unsigned char* texels { nullptr };
+                TilePtr tile {};
+            };
+            std::array<Slot, 1 << bits> slots {};
+        };
+
+        std::mutex mutex_ {};
+        std::size_t capacity_ { std::numeric_limits<std::size_t>::max() };
+        // Most recently used first
+        std::list<Key> lru_ {};
+        std::unordered_map<Key, Entry> resident_ {};
+        std::unordered_map<Key, Page> pages_ {};
+        // Stretches of the scratch file released with their images, by
+        // size, filled again before the file grows
+        std::multimap<std::size_t, long> free_pages_ {};
+        std::FILE* scratch_ { nullptr };
+        std::uint32_t next_image_ { 0 };
+        Stats stats_ {};
+        // Unlike the address, never reused by a later cache
+        const std::uint64_t id_ { next_id() };
+
+        static std::uint64_t next_id() {
+            static std::atomic<std::uint64_t> next { 1 };
+            return next++;
+        }
+
+        static std::size_t bytes(const Tile& tile) {
+            return tile.size();
+        }
+
+        void touch(Entry& entry) {
+            lru_.splice(lru_.begin(), lru_, entry.lru);
+        }
+
+        // Room for bytes in the scratch file: the smallest released stretch
+        // that fits, with what it has left over released again, or else
+        // the end of the file
+        Page allocate_page(std::size_t bytes) {
+            const auto it { free_pages_.lower_bound(bytes) };
+            if (it == free_pages_.end()) {
+                std::fseek(scratch_, 0, SEEK_END);
+                return Page { std::ftell(scratch_), bytes };
+            }
+            const auto [size, offset] { *it };
+            free_pages_.erase(it);
+            if (size > bytes) {
+                free_pages_.emplace(
+                    size - bytes, offset + static_cast<long>(bytes)
+                );
+            }
+            return Page { offset, bytes };
+        }
+
+        // Writes key's tile out if it has never been, and drops it
+        void evict(Key key) {
+            const auto it { resident_.find(key) };
+            const auto& tile { *it->second.tile };
+            if (!pages_.count(key)) {
+                if (!scratch_) scratch_ = std::tmpfile();
+                if (!scratch_) {
+                    throw std::runtime_error("Failed to open texture scratch");
+                }
+                const auto page { allocate_page(tile.size()) };
+                std::fseek(scratch_, page.offset, SEEK_SET);
+                std::fwrite(tile.data(), 1, tile.size(), scratch_);
+                pages_.emplace(key, page);
+            }
+            stats_.resident -= bytes(tile);
+            stats_.evictions++;
+            lru_.erase(it->second.lru);
+            resident_.erase(it);
+        }
+
+        void shrink() {
+            // The most recent tile always stays, whatever the capacity
+            while (stats_.resident > capacity_ && lru_.size() > 1) {
+                evict(lru_.back());
+            }
+        }
+
+        TilePtr insert_locked(Key key, TilePtr tile) {
+            stats_.resident += bytes(*tile);
+            stats_.peak = std::max(stats_.peak, stats_.resident);
+            lru_.push_front(key);
+            resident_[key] = Entry { tile, lru_.begin() };
+            shrink();
+            return tile;
+        }
+
+        TilePtr fetch_locked(Key key) {
+            stats_.fetches++;
+            const auto it { resident_.find(key) };
+            if (it != resident_.end()) {
+                touch(it->second);
+                return it->second.tile;
+            }
+
+            const auto page { pages_.find(key) };
+            if (page == pages_.end()) {
+                throw std::runtime_error("Texture tile missing from cache");
+            }
+            auto tile { std::make_shared<Tile>(page->second.bytes) };
+            std::fseek(scratch_, page->second.offset, SEEK_SET);
+            if (
+                std::fread(tile->data(), 1, tile->size(), scratch_)
+                != tile->size()
+            ) {
+                throw std::runtime_error("Failed to read texture tile");
+            }
+            stats_.reads++;
+            return insert_locked(key, std::move(tile));
+        }
+
+    public:
+        TextureCache() = default;
+        TextureCache(const TextureCache&) = delete;
+        TextureCache& operator=(const TextureCache&) = delete;
+
+        ~TextureCache() {
+            if (scratch_) std::fclose(scratch_);
+        }
+
+        static TextureCache& global() {
+            static TextureCache cache {};
+            return cache;
+        }
+
+        static Key key(std::uint32_t image, int level, int tile) {
+            return (static_cast<Key>(image) << 40)
+                | (static_cast<Key>(level) << 32)
+                | static_cast<Key>(static_cast<std::uint32_t>(tile));
+        }
+
+        // Whether tiles can be evicted. Set the capacity before loading
+        // textures: those loaded while the cache is unbounded hold on to
+        // their tiles.
+        bool bounded() {
+            std::lock_guard lock { mutex_ };
+            return capacity_ != std::numeric_limits<std::size_t>::max();
+        }
+
+        // Most bytes of tiles to keep in memory
+        void set_capacity(std::size_t capacity) {
+            std::lock_guard lock { mutex_ };
+            capacity_ = capacity;
+            shrink();
+        }
+
+        // Identifier for the tiles of a new image
+        std::uint32_t add_image() {
+            std::lock_guard lock { mutex_ };
+            return next_image_++;
+        }
+
+        // Forgets every tile of image, and releases its pages of the
+        // scratch file. The file is closed, and so deleted, once it holds
+        // no pages at all.
+        void remove_image(std::uint32_t image) {
+            std::lock_guard lock { mutex_ };
+            const auto owned { [image](Key key) {
+                return static_cast<std::uint32_t>(key >> 40) == image;
+            } };
+            for (auto it { lru_.begin() }; it != lru_.end();) {
+                const auto key { *it++ };
+                if (!owned(key)) continue;
+                const auto entry { resident_.find(key) };
+                stats_.resident -= bytes(*entry->second.tile);
+                lru_.erase(entry->second.lru);
+                resident_.erase(entry);
+            }
+            for (auto it { pages_.begin() }; it != pages_.end();) {
+                if (!owned(it->first)) {
+                    ++it;
+                    continue;
+                }
+                free_pages_.emplace(it->second.bytes, it->second.offset);
+                it = pages_.erase(it);
+            }
+            if (scratch_ && pages_.empty()) {
+                std::fclose(scratch_);
+                scratch_ = nullptr;
+                free_pages_.clear();
+            }
+        }
+
+        TilePtr insert(Key key, Tile tile) {
+            std::lock_guard lock { mutex_ };
+            return insert_locked(
+                key, std::make_shared<const Tile>(std::move(tile))
+            );
+        }
+
+        // Texels of the tile for key, paged back in if it was evicted. The
+        // pointer is only good until the calling thread's next fetch. Kept
+        // out of line: inlined, it bloats the texture lookups that call it
+        // and slows them down even when they never get here.
+        [[gnu::noinline]] const unsigned char* fetch(Key key) {
+            thread_local MicroCache micro {};
+            // Fibonacci hashing, so tiles of neighbouring levels and images
+            // spread over the slots
+            auto& slot { micro.slots[
+                (key * 0x9e3779b97f4a7c15ull) >> (64 - MicroCache::bits)
+            ] };
+            if (slot.owner != id_ || slot.key != key) {
+                std::lock_guard lock { mutex_ };
+                slot.tile = fetch_locked(key);
+                slot.texels = slot.tile->data();
+                slot.owner = id_;
+                slot.key = key;
+            }
+            return slot.texels;
+        }
+
+        Stats stats() {
+            std::lock_guard lock { mutex_ };
+            auto stats { stats_ };
+            stats.capacity = capacity_;
+            return stats;
+        }
+};
+
+#endif
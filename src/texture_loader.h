@@ -0,0 +1,114 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "texture_cache.h"
+
+// Background threads that decode image textures while the rest of the
+// scene, its BVHs included, is built. Textures queue their loads as they
+// are created and the scene waits for all of them once it is complete. The
+// threads start with the first load, so scenes without image textures never
+// pay for them.
+class TextureLoader {
+    private:
+        const int threads_;
+        std::vector<std::thread> workers_ {};
+        std::mutex mutex_ {};
+        std::condition_variable work_ready_ {};
+        std::condition_variable work_done_ {};
+        std::deque<std::function<void()>> queue_ {};
+        // Jobs taken off the queue and still running
+        int running_ { 0 };
+        bool stopping_ { false };
+        // First failure since the last wait
+        std::exception_ptr error_ {};
+
+        void work() {
+            std::unique_lock lock { mutex_ };
+            for (;;) {
+                work_ready_.wait(lock, [this] {
+                    return stopping_ || !queue_.empty();
+                });
+                if (queue_.empty()) return;
+
+                auto job { std::move(queue_.front()) };
+                queue_.pop_front();
+                running_++;
+                lock.unlock();
+                std::exception_ptr error {};
+                try {
+                    job();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                lock.lock();
+
+                if (error && !error_) error_ = error;
+                if (--running_ == 0 && queue_.empty()) {
+                    work_done_.notify_all();
+                }
+            }
+        }
+
+    public:
+        explicit TextureLoader(
+            int threads = static_cast<int>(std::thread::hardware_concurrency())
+        ) : threads_ { std::max(1, threads) } {
+            // Jobs fill the global texture cache, so it has to be set up
+            // first and torn down after the workers
+            TextureCache::global();
+        }
+
+        TextureLoader(const TextureLoader&) = delete;
+        TextureLoader& operator=(const TextureLoader&) = delete;
+
+        // Finishes the jobs already queued before stopping
+        ~TextureLoader() {
+            {
+                std::lock_guard lock { mutex_ };
+                stopping_ = true;
+            }
+            work_ready_.notify_all();
+            for (auto& worker : workers_) {
+                worker.join();
+            }
+        }
+
+        static TextureLoader& global() {
+            static TextureLoader loader {};
+            return loader;
+        }
+
+        // Queues job to run on one of the workers
+        void load(std::function<void()> job) {
+            {
+                std::lock_guard lock { mutex_ };
+                queue_.push_back(std::move(job));
+                while (static_cast<int>(workers_.size()) < threads_) {
+                    workers_.emplace_back([this] { work(); });
+                }
+            }
+            work_ready_.notify_one();
+        }
+
+        // Returns once every queued job has finished, rethrowing the first
+        // exception any of them threw
+        void wait() {
+            std::unique_lock lock { mutex_ };
+            work_done_.wait(lock, [this] {
+                return running_ == 0 && queue_.empty();
+            });
+            if (error_) std::rethrow_exception(std::exchange(error_, {}));
+        }
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include "mipmap.h"
+#include "rtw_stb_image.h"
+#include "texture_cache.h"
+#include "texture_loader.h"
+
+// Process-wide table of loaded images, so every texture naming the same
+// file shares one mip pyramid, in one scene or across a batch. Images are
+// keyed by the file found for their name, so different names for one file
+// share it too. Entries are held weakly: an image is freed once nothing
+// uses it, and loaded again if asked for later.
+class TextureRegistry {
+    public:
+        // Filled in by the background load job
+        struct Image {
+            std::unique_ptr<const MipMap> mip {};
+        };
+        using Handle = std::shared_ptr<const Image>;
+
+        struct Stats {
+            // Images alive
+            std::size_t images { 0 };
+            // Requests for an image, and those answered by one already
+            // loaded
+            std::size_t requests { 0 };
+            std::size_t shared { 0 };
+            TextureCache::Stats cache {};
+        };
+
+    private:
+        std::mutex mutex_ {};
+        std::unordered_map<std::string, std::weak_ptr<Image>> images_ {};
+        std::size_t requests_ { 0 };
+        std::size_t shared_ { 0 };
+
+    public:
+        static TextureRegistry& global() {
+            static TextureRegistry registry {};
+            return registry;
+        }
+
+        // The image in filename, queued on the texture loader the first
+        // time it is asked for
+        Handle image(const std::string& filename) {
+            const auto path { rtw_image::resolve(filename) };
+            const auto key { path.empty() ? filename : path };
+
+            std::lock_guard lock { mutex_ };
+            requests_++;
+            auto& entry { images_[key] };
+            if (auto image { entry.lock() }) {
+                shared_++;
+                return image;
+            }
+
+            auto image { std::make_shared<Image>() };
+            entry = image;
+            TextureLoader::global().load([image, key] {
+                image->mip = std::make_unique<const MipMap>(
+                    rtw_image { key.c_str() }
+                );
+            });
+            return image;
+        }
+
+        Stats stats() {
+            Stats stats { 0, 0, 0, TextureCache::global().stats() };
+            std::lock_guard lock { mutex_ };
+            for (auto it { images_.begin() }; it != images_.end();) {
+                if (it->second.expired()) {
+                    it = images_.erase(it);
+                } else {
+                    stats.images++;
+                    ++it;
+                }
+            }
+            stats.requests = requests_;
+            stats.shared = shared_;
+            return stats;
+        }
+};
+
+inline std::ostream& operator<<(
+    std::ostream& os, const TextureRegistry::Stats& stats
+) {
+    const auto mib { [](std::size_t bytes) { return bytes / 1048576.0; } };
+    os << "TextureStats(\n"
+        << "\timages=" << stats.images << "\n"
+        << "\trequests=" << stats.requests << "\n"
+        << "\tshared=" << stats.shared << "\n"
+        << "\tresident_mib=" << mib(stats.cache.resident) << "\n"
+        << "\tpeak_mib=" << mib(stats.cache.peak) << "\n"
+        << "\ttile_reads=" << stats.cache.reads << "\n"
+        << "\tevictions=" << stats.cache.evictions << "\n"
+        << ")";
+    return os;
+}
+
+#endif
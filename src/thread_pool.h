@@ -0,0 +1,89 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, started once and reused by every render, so
+// a batch of images does not pay for spinning threads up for each of them
+class ThreadPool {
+    private:
+        std::vector<std::thread> workers_ {};
+        std::mutex mutex_ {};
+        std::condition_variable work_ready_ {};
+        std::condition_variable work_done_ {};
+        // The job being run: tasks [0, task_count_) of task_
+        std::function<void(int)> task_ {};
+        int task_count_ { 0 };
+        int next_task_ { 0 };
+        int finished_ { 0 };
+        bool stopping_ { false };
+
+        void work() {
+            std::unique_lock lock { mutex_ };
+            for (;;) {
+                work_ready_.wait(lock, [this] {
+                    return stopping_ || next_task_ < task_count_;
+                });
+                if (stopping_) return;
+
+                const auto task { next_task_++ };
+                lock.unlock();
+                task_(task);
+                lock.lock();
+
+                if (++finished_ == task_count_) {
+                    work_done_.notify_all();
+                }
+            }
+        }
+
+    public:
+        explicit ThreadPool(
+            int threads = static_cast<int>(std::thread::hardware_concurrency())
+        ) {
+            for (int i = 0; i < std::max(1, threads); ++i) {
+                workers_.emplace_back([this] { work(); });
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard lock { mutex_ };
+                stopping_ = true;
+            }
+            work_ready_.notify_all();
+            for (auto& worker : workers_) {
+                worker.join();
+            }
+        }
+
+        int size() const { return static_cast<int>(workers_.size()); }
+
+        // Runs task(0), ..., task(count - 1) on the workers and returns once
+        // all of them have finished
+        void run(int count, const std::function<void(int)>& task) {
+            if (count <= 0) return;
+
+            std::unique_lock lock { mutex_ };
+            task_ = task;
+            task_count_ = count;
+            next_task_ = 0;
+            finished_ = 0;
+            work_ready_.notify_all();
+            work_done_.wait(lock, [this] { return finished_ == task_count_; });
+
+            task_count_ = 0;
+            next_task_ = 0;
+            task_ = {};
+        }
+};
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <array>
+#include <cmath>
+
+#include "aabb.h"
+#include "raytracing.h"
+#include "vec3.h"
+
+// Affine transform stored as the top three rows of a 4x4 matrix: a 3x3
+// linear part (rotation, scale, shear) and a translation column
+class Affine {
+    private:
+        std::array<std::array<Real, 4>, 3> m_ {};
+
+    public:
+        // Identity
+        Affine() : m_ {{ {1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0} }} {}
+
+        Real operator()(int row, int col) const { return m_[row][col]; }
+        Real& operator()(int row, int col) { return m_[row][col]; }
+
+        static Affine translation(const Direction3& offset) {
+            Affine a {};
+            for (int i = 0; i < 3; i++) {
+                a(i, 3) = offset[i];
+            }
+            return a;
+        }
+
+        static Affine scaling(Real sx, Real sy, Real sz) {
+            Affine a {};
+            a(0, 0) = sx;
+            a(1, 1) = sy;
+            a(2, 2) = sz;
+            return a;
+        }
+
+        static Affine scaling(Real s) {
+            return scaling(s, s, s);
+        }
+
+        // Counter-clockwise rotation by angle degrees about axis, looking
+        // down the axis towards the origin (Rodrigues' formula)
+        static Affine rotation(const Direction3& axis, double angle) {
+            const auto k { unit_vector(axis) };
+            const auto radians { degrees_to_radians(angle) };
+            const auto c { static_cast<Real>(std::cos(radians)) };
+            const auto s { static_cast<Real>(std::sin(radians)) };
+            const auto t { 1 - c };
+
+            Affine a {};
+            a(0, 0) = c + t * k.x() * k.x();
+            a(0, 1) = t * k.x() * k.y() - s * k.z();
+            a(0, 2) = t * k.x() * k.z() + s * k.y();
+            a(1, 0) = t * k.y() * k.x() + s * k.z();
+            a(1, 1) = c + t * k.y() * k.y();
+            a(1, 2) = t * k.y() * k.z() - s * k.x();
+            a(2, 0) = t * k.z() * k.x() - s * k.y();
+            a(2, 1) = t * k.z() * k.y() + s * k.x();
+            a(2, 2) = c + t * k.z() * k.z();
+            return a;
+        }
+
+        Point3 point(const Point3& p) const {
+            return direction(p)
+                + Direction3 { m_[0][3], m_[1][3], m_[2][3] };
+        }
+
+        Direction3 direction(const Direction3& d) const {
+            return Direction3 {
+                m_[0][0] * d.x() + m_[0][1] * d.y() + m_[0][2] * d.z(),
+                m_[1][0] * d.x() + m_[1][1] * d.y() + m_[1][2] * d.z(),
+                m_[2][0] * d.x() + m_[2][1] * d.y() + m_[2][2] * d.z()
+            };
+        }
+
+        // Applies the transpose of the linear part. On the inverse of a
+        // transform this maps normals through that transform.
+        Direction3 transpose_direction(const Direction3& d) const {
+            return Direction3 {
+                m_[0][0] * d.x() + m_[1][0] * d.y() + m_[2][0] * d.z(),
+                m_[0][1] * d.x() + m_[1][1] * d.y() + m_[2][1] * d.z(),
+                m_[0][2] * d.x() + m_[1][2] * d.y() + m_[2][2] * d.z()
+            };
+        }
+
+        Affine inverse() const {
+            const auto& m { m_ };
+            const auto c00 { m[1][1] * m[2][2] - m[1][2] * m[2][1] };
+            const auto c01 { m[1][2] * m[2][0] - m[1][0] * m[2][2] };
+            const auto c02 { m[1][0] * m[2][1] - m[1][1] * m[2][0] };
+            const auto inv_det {
+                1 / (m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02)
+            };
+
+            Affine a {};
+            a(0, 0) = c00 * inv_det;
+            a(0, 1) = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+            a(0, 2) = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+            a(1, 0) = c01 * inv_det;
+            a(1, 1) = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+            a(1, 2) = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+            a(2, 0) = c02 * inv_det;
+            a(2, 1) = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+            a(2, 2) = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
+
+            const auto offset {
+                a.direction(Direction3 { m[0][3], m[1][3], m[2][3] })
+            };
+            for (int i = 0; i < 3; i++) {
+                a(i, 3) = -offset[i];
+            }
+            return a;
+        }
+
+        // Tightest box around the transformed corners of box
+        AABB bounds(const AABB& box) const {
+            Point3 min {};
+            Point3 max {};
+            for (int i = 0; i < 3; i++) {
+                min[i] = max[i] = m_[i][3];
+                for (int j = 0; j < 3; j++) {
+                    const auto a { m_[i][j] * box[j].min() };
+                    const auto b { m_[i][j] * box[j].max() };
+                    min[i] += std::fmin(a, b);
+                    max[i] += std::fmax(a, b);
+                }
+            }
+            return AABB { min, max };
+        }
+};
+
+// Applies b first, then a
+inline Affine operator*(const Affine& a, const Affine& b) {
+    Affine c {};
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            c(i, j) = j == 3 ? a(i, 3) : 0;
+            for (int k = 0; k < 3; k++) {
+                c(i, j) += a(i, k) * b(k, j);
+            }
+        }
+    }
+    return c;
+}
+
+#endif
@@ -7,35 +7,47 @@
 #include "concepts.h"
 #include "random.h"
 #include "raytracing.h"
+#include "simd.h"
 
 template <typename T>
 class Vec3 {
     private:
-        T e[3];
+        // Padded to a full four lane register; lane 3 is never read back
+        simd::Lanes<T> e;
 
     public:
-        Vec3() : e{0, 0, 0} {}
-        Vec3(T e0, T e1, T e2) : e{e0, e1, e2} {}
+        Vec3() : e{0, 0, 0, 0} {}
+        Vec3(T e0, T e1, T e2) : e{e0, e1, e2, 0} {}
+        explicit Vec3(const simd::Lanes<T>& lanes) : e{lanes} {}
+        // Conversion between precisions, e.g. double shading values to
+        // single precision geometry
+        template <Arithmetic U>
+        explicit Vec3(const Vec3<U>& v)
+            : e{
+                static_cast<T>(v[0]),
+                static_cast<T>(v[1]),
+                static_cast<T>(v[2]),
+                0
+            } {}
+
+        const simd::Lanes<T>& lanes() const { return e; }
 
         T x() const { return e[0]; }
         T y() const { return e[1]; }
         T z() const { return e[2]; }
 
-        Vec3 operator-() const { return Vec3{-e[0], -e[1], -e[2]}; }
+        Vec3 operator-() const { return Vec3 { -e }; }
         T operator[](int i) const { return e[i]; }
-        T& operator[](int i) { return e[i]; }
+        // Vector types alias their element type
+        T& operator[](int i) { return reinterpret_cast<T*>(&e)[i]; }
 
         Vec3& operator+=(const Vec3 v) {
-            e[0] += v.e[0];
-            e[1] += v.e[1];
-            e[2] += v.e[2];
+            e = e + v.e;
             return *this;
         }
 
         Vec3& operator*=(const T t) {
-            e[0] *= t;
-            e[1] *= t;
-            e[2] *= t;
+            e = e * simd::broadcast(t);
             return *this;
         }
 
@@ -77,7 +89,7 @@ class Vec3 {
         }
 
         T length_squared() const {
-            return e[0]*e[0] + e[1]*e[1] + e[2]*e[2];
+            return simd::sum3(e * e);
         }
 
         bool near_zero() const {
@@ -111,20 +123,12 @@ inline std::ostream& operator<<(std::ostream& out, const Vec3<T>& v) {
 
 template <Arithmetic T>
 inline Vec3<T> operator+(const Vec3<T>& u, const Vec3<T>& v) {
-    return Vec3<T> {
-        u[0] + v[0],
-        u[1] + v[1],
-        u[2] + v[2]
-    };
+    return Vec3<T> { u.lanes() + v.lanes() };
 }
 
 template <Arithmetic T, Arithmetic U>
 inline Vec3<T> operator+(const Vec3<T>& u, U v) {
-    return Vec3<T> {
-        u[0] + static_cast<T>(v),
-        u[1] + static_cast<T>(v),
-        u[2] + static_cast<T>(v)
-    };
+    return Vec3<T> { u.lanes() + simd::broadcast(static_cast<T>(v)) };
 }
 
 template <Arithmetic T, Arithmetic U>
@@ -134,7 +138,7 @@ inline Vec3<T> operator+(U u, const Vec3<T>& v) {
 
 template <Arithmetic T>
 inline Vec3<T> operator-(const Vec3<T>& u, const Vec3<T>& v) {
-    return u + (-v);
+    return Vec3<T> { u.lanes() - v.lanes() };
 }
 
 template <Arithmetic T, Arithmetic U>
@@ -149,20 +153,12 @@ inline Vec3<T> operator-(U u, const Vec3<T>& v) {
 
 template <Arithmetic T>
 inline Vec3<T> operator*(const Vec3<T>& v, const Vec3<T>& t) {
-    return Vec3<T> {
-        v[0] * t[0],
-        v[1] * t[1],
-        v[2] * t[2]
-    };
+    return Vec3<T> { v.lanes() * t.lanes() };
 }
 
 template <Arithmetic T, Arithmetic U>
 inline Vec3<T> operator*(const Vec3<T>& t, U v) {
-    return Vec3<T> {
-        t[0] * v,
-        t[1] * v,
-        t[2] * v
-    };
+    return Vec3<T> { t.lanes() * simd::broadcast(static_cast<T>(v)) };
 }
 
 template <Arithmetic T, Arithmetic U>
@@ -177,67 +173,101 @@ inline Vec3<T> operator/(const Vec3<T>& v, U t) {
 
 template <Arithmetic T>
 inline T dot(const Vec3<T>& u, const Vec3<T>& v) {
-    return u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+    return simd::sum3(u.lanes() * v.lanes());
 }
 
+// u x v = (u * v.yzx - u.yzx * v).yzx, two shuffles fewer than the
+// textbook form
 template <Arithmetic T>
 inline Vec3<T> cross(const Vec3<T>& u, const Vec3<T>& v) {
-    return Vec3<T> {
-        u[1] * v[2] - u[2] * v[1],
-        u[2] * v[0] - u[0] * v[2],
-        u[0] * v[1] - u[1] * v[0]
-    };
+    const auto a { u.lanes() };
+    const auto b { v.lanes() };
+    return Vec3<T> { simd::yzx(a * simd::yzx(b) - simd::yzx(a) * b) };
 }
 
 template <Arithmetic T>
 inline Vec3<T> unit_vector(const Vec3<T>& v) {
-    return v / v.length();
+    return v * (T(1) / std::sqrt(dot(v, v)));
 }
 
-inline Vec3<double> random_unit_vector() {
-    const auto theta { gen_rand::random_double(0, pi) };
+// Type aliases
+using Point3 = Vec3<Real>;
+using Direction3 = Vec3<Real>;
+
+// Uniformly distributed over the unit sphere, pdf 1 / (4 pi)
+inline Direction3 random_unit_vector() {
+    const auto z { gen_rand::random_double(-1, 1) };
     const auto phi { gen_rand::random_double(0, 2 * pi) };
-    const auto sin_theta { std::sin(theta) };
-    const auto x { sin_theta * std::cos(phi) };
-    const auto y { sin_theta * std::sin(phi) };
-    const auto z { std::cos(theta) };
-    return Vec3<double> { x, y, z };
+    const auto r { std::sqrt(std::fmax(0.0, 1 - z * z)) };
+    const auto x { r * std::cos(phi) };
+    const auto y { r * std::sin(phi) };
+    return Direction3 { Vec3<double> { x, y, z } };
+}
+
+// Cosine weighted about the +z axis, pdf cos(theta) / pi
+inline Direction3 random_cosine_direction() {
+    const auto r1 { gen_rand::random_double() };
+    const auto r2 { gen_rand::random_double() };
+    const auto phi { 2 * pi * r1 };
+    const auto x { std::cos(phi) * std::sqrt(r2) };
+    const auto y { std::sin(phi) * std::sqrt(r2) };
+    const auto z { std::sqrt(1 - r2) };
+    return Direction3 { Vec3<double> { x, y, z } };
 }
 
-inline Vec3<double> random_on_hemisphere(const Vec3<double>& normal) {
+// Phong lobe of the given exponent about the +z axis,
+// pdf (exponent + 1) / (2 pi) * cos(theta)^exponent
+inline Direction3 random_phong_direction(double exponent) {
+    const auto r1 { gen_rand::random_double() };
+    const auto r2 { gen_rand::random_double() };
+    const auto phi { 2 * pi * r1 };
+    const auto z { std::pow(r2, 1 / (exponent + 1)) };
+    const auto r { std::sqrt(std::fmax(0.0, 1 - z * z)) };
+    return Direction3 {
+        Vec3<double> { r * std::cos(phi), r * std::sin(phi), z }
+    };
+}
+
+inline Direction3 random_on_hemisphere(const Direction3& normal) {
     const auto on_unit_sphere { random_unit_vector() };
     return dot(on_unit_sphere, normal) > 0.0
         ? on_unit_sphere
         : -on_unit_sphere;
 }
 
-inline Vec3<double> random_in_unit_disk() {
+inline Direction3 random_in_unit_disk() {
     const auto angle { gen_rand::random_double(0, 2 * pi) };
     const auto r { gen_rand::random_double(0, 1) };
     const auto x { r * std::cos(angle) };
     const auto y { r * std::sin(angle) };
-    return Vec3<double> { x, y, 0 };
+    return Direction3 { Vec3<double> { x, y, 0 } };
 }
 
 template <Arithmetic T>
 inline Vec3<T> reflect(const Vec3<T>& v, const Vec3<T>& n) {
-    return v - 2 * dot(v, n) * n;
+    const auto n_lanes { n.lanes() };
+    return Vec3<T> {
+        v.lanes() - n_lanes * simd::broadcast(2 * dot(v, n))
+    };
 }
 
 template <Arithmetic T>
 inline Vec3<T> refract(
     const Vec3<T>& uv, const Vec3<T>& n, double etai_over_etat
 ) {
-    const auto cos_theta { std::fmin(dot(-uv, n), 1.0) };
-    const auto r_out_perp { etai_over_etat * (uv + cos_theta * n) };
-    const auto r_out_parallel {
-        -std::sqrt(1.0 - r_out_perp.length_squared()) * n
+    const auto eta { static_cast<T>(etai_over_etat) };
+    const auto cos_theta { std::fmin(-dot(uv, n), T(1)) };
+    const auto n_lanes { n.lanes() };
+    const Vec3<T> r_out_perp {
+        (uv.lanes() + n_lanes * simd::broadcast(cos_theta))
+            * simd::broadcast(eta)
+    };
+    const auto parallel {
+        -std::sqrt(std::fabs(T(1) - dot(r_out_perp, r_out_perp)))
+    };
+    return Vec3<T> {
+        r_out_perp.lanes() + n_lanes * simd::broadcast(parallel)
     };
-    return r_out_perp + r_out_parallel;
 }
 
-// Type aliases
-using Point3 = Vec3<double>;
-using Direction3 = Vec3<double>;
-
 #endif
@@ -0,0 +1,252 @@
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "aabb.h"
+#include "colour.h"
+#include "hittable.h"
+#include "material.h"
+#include "ray.h"
+#include "world.h"
+
+// Wavefront path tracer. Instead of following one path to completion, a
+// whole batch of paths advances one bounce at a time: every live path is
+// intersected, then the hits are grouped by material type and each group is
+// shaded by a kernel calling that material's final class directly. Paths
+// that escape or are absorbed drop out of the queue after each stage.
+// Secondary rays are reordered before tracing so that neighbouring rays in
+// the queue start close together and head the same way, and so walk the
+// same BVH nodes.
+class WavefrontIntegrator {
+    private:
+        static constexpr std::size_t material_types {
+            static_cast<std::size_t>(MaterialType::Other) + 1
+        };
+        // Fewer live paths than this are traced in queue order: too few
+        // of them share BVH nodes for sorting to pay for itself
+        static constexpr std::size_t min_reorder_paths { 1024 };
+
+        // Path state as a structure of arrays, indexed by path
+        struct Paths {
+            std::vector<Ray> rays {};
+            std::vector<RayCone> cones {};
+            std::vector<HitRecord> hits {};
+            std::vector<Colour> radiance {};
+            std::vector<Colour> throughput {};
+            std::vector<double> bsdf_pdf {};
+            std::vector<char> specular {};
+
+            void reset(const std::vector<Ray>& camera_rays, double spread) {
+                const auto n { camera_rays.size() };
+                rays = camera_rays;
+                cones.assign(n, RayCone { 0, spread });
+                hits.resize(n);
+                radiance.assign(n, Colour(0, 0, 0));
+                throughput.assign(n, Colour(1, 1, 1));
+                bsdf_pdf.assign(n, 0);
+                specular.assign(n, true);
+            }
+        };
+
+        const World& world_;
+        const int max_depth_;
+        // Angle a camera ray's cone spreads by, one pixel
+        const double pixel_spread_;
+        Paths paths_ {};
+        // Indices of the live paths, and the queue being built for the
+        // next stage
+        std::vector<std::size_t> active_ {};
+        std::vector<std::size_t> next_ {};
+        std::array<std::vector<std::size_t>, material_types> shade_queues_ {};
+        // (sort key, path) pairs used to reorder the live paths
+        std::vector<std::pair<std::uint64_t, std::size_t>> sort_keys_ {};
+        // Per axis, origin coordinates map onto Morton cells as
+        // (x - cell_min_) * cell_scale_
+        std::array<Real, 3> cell_min_ {};
+        std::array<Real, 3> cell_scale_ {};
+
+        // Checked on the bits, since -ffast-math, which Release builds use,
+        // lets the compiler assume std::isfinite() always holds
+        static bool is_finite(Real x) {
+            using Bits = std::conditional_t<
+                sizeof(Real) == 4, std::uint32_t, std::uint64_t
+            >;
+            const auto exponent {
+                std::bit_cast<Bits>(std::numeric_limits<Real>::infinity())
+            };
+            return (std::bit_cast<Bits>(x) & exponent) != exponent;
+        }
+
+        // An axis the scene is unbounded along, or flat in, has no cells,
+        // so it contributes nothing to the key
+        void set_cells(const AABB& bounds) {
+            for (int axis = 0; axis < 3; axis++) {
+                const auto& extent { bounds[axis] };
+                const auto size { extent.size() };
+                if (size > 0 && is_finite(size)) {
+                    cell_min_[axis] = extent.min();
+                    cell_scale_[axis] = 1023 / size;
+                }
+            }
+        }
+
+        // Spreads the low 10 bits of v so there are two zero bits between
+        // each of them
+        static std::uint64_t spread_bits(std::uint64_t v) {
+            v &= 0x3ff;
+            v = (v | (v << 16)) & 0x030000ff;
+            v = (v | (v << 8)) & 0x0300f00f;
+            v = (v | (v << 4)) & 0x030c30c3;
+            v = (v | (v << 2)) & 0x09249249;
+            return v;
+        }
+
+        // Octant of the direction above a 30 bit Morton code of the origin
+        // within the scene bounds
+        std::uint64_t sort_key(const Ray& r) const {
+            std::uint64_t key { 0 };
+            for (int axis = 0; axis < 3; axis++) {
+                const auto t {
+                    (r.origin()[axis] - cell_min_[axis]) * cell_scale_[axis]
+                };
+                const auto cell { static_cast<std::uint64_t>(
+                    std::clamp(t, Real(0), Real(1023))
+                ) };
+                key |= spread_bits(cell) << (2 - axis);
+                const auto sign { static_cast<std::uint64_t>(r.sign(axis)) };
+                key |= sign << (30 + axis);
+            }
+            return key;
+        }
+
+        void reorder() {
+            sort_keys_.clear();
+            for (const auto i : active_) {
+                sort_keys_.emplace_back(sort_key(paths_.rays[i]), i);
+            }
+            std::sort(sort_keys_.begin(), sort_keys_.end());
+            for (std::size_t k = 0; k < sort_keys_.size(); k++) {
+                active_[k] = sort_keys_[k].second;
+            }
+        }
+
+        void intersect() {
+            next_.clear();
+            for (const auto i : active_) {
+                auto& rec { paths_.hits[i] };
+                rec = HitRecord {};
+                auto& cone { paths_.cones[i] };
+                const auto& r { paths_.rays[i] };
+                if (world_.intersect(r, rec, cone)) {
+                    cone = cone.at(World::hit_distance(r, rec));
+                    next_.push_back(i);
+                } else {
+                    paths_.radiance[i] += paths_.throughput[i]
+                        * world_.background();
+                }
+            }
+            std::swap(active_, next_);
+        }
+
+        // One bounce for every path in queue, whose hits all have material
+        // type M; the surviving paths are appended to next_
+        template <typename M>
+        void shade(const std::vector<std::size_t>& queue) {
+            for (const auto i : queue) {
+                const auto& rec { paths_.hits[i] };
+                const auto& mat { static_cast<const M&>(*rec.mat) };
+                const auto& r { paths_.rays[i] };
+                auto& throughput { paths_.throughput[i] };
+                auto& radiance { paths_.radiance[i] };
+
+                radiance += throughput * world_.emission(
+                    mat, r, rec, paths_.specular[i], paths_.bsdf_pdf[i]
+                );
+
+                ScatterRecord srec {};
+                if (!mat.sample(r, rec, srec)) continue;
+
+                if (!srec.is_specular && world_.has_lights()) {
+                    radiance += throughput
+                        * world_.sample_lights(mat, r, rec);
+                }
+
+                throughput = throughput * srec.attenuation;
+                paths_.specular[i] = srec.is_specular;
+                paths_.bsdf_pdf[i] = srec.pdf;
+                paths_.rays[i] = srec.scattered;
+                next_.push_back(i);
+            }
+        }
+
+        void shade() {
+            for (auto& queue : shade_queues_) {
+                queue.clear();
+            }
+            for (const auto i : active_) {
+                const auto type { paths_.hits[i].mat->type() };
+                shade_queues_[static_cast<std::size_t>(type)].push_back(i);
+            }
+
+            next_.clear();
+            shade<Lambertian>(queue(MaterialType::Lambertian));
+            shade<Metal>(queue(MaterialType::Metal));
+            shade<Dielectric>(queue(MaterialType::Dielectric));
+            shade<DiffuseLight>(queue(MaterialType::DiffuseLight));
+            shade<Isotropic>(queue(MaterialType::Isotropic));
+            shade<Material>(queue(MaterialType::Other));
+            std::swap(active_, next_);
+        }
+
+        const std::vector<std::size_t>& queue(MaterialType type) const {
+            return shade_queues_[static_cast<std::size_t>(type)];
+        }
+
+    public:
+        WavefrontIntegrator() = delete;
+        WavefrontIntegrator(
+            const World& world, int max_depth, double pixel_spread = 0
+        ) : world_ { world },
+            max_depth_ { max_depth },
+            pixel_spread_ { pixel_spread } {
+            set_cells(world.bounding_box());
+        }
+
+        // Radiance along each of the camera rays, in the same order
+        const std::vector<Colour>& trace(const std::vector<Ray>& rays) {
+            paths_.reset(rays, pixel_spread_);
+            active_.resize(rays.size());
+            for (std::size_t i { 0 }; i < rays.size(); i++) {
+                active_[i] = i;
+            }
+
+            for (int depth { max_depth_ }; depth > 0; depth--) {
+                if (active_.empty()) break;
+                // Camera rays are already coherent in pixel order
+                if (depth < max_depth_ && active_.size() >= min_reorder_paths) {
+                    reorder();
+                }
+                intersect();
+                shade();
+            }
+
+            // Paths cut off by the depth limit see the background, as in
+            // World::ray_colour
+            for (const auto i : active_) {
+                paths_.radiance[i] += paths_.throughput[i]
+                    * world_.background();
+            }
+            return paths_.radiance;
+        }
+};
+
+#endif
@@ -11,35 +11,146 @@ class World {
     private:
         std::shared_ptr<HittableList> world_;
         Colour background_;
+        // Emitters that are sampled explicitly at every non-specular vertex
+        HittableList lights_;
+
+        static constexpr IntervalR ray_t { 0.001, infinity_r };
+        // Relative shortening of shadow rays so they stop short of the light
+        static constexpr Real shadow_epsilon { Real(1e-4) };
+
+        static double power_heuristic(double pdf_a, double pdf_b) {
+            const auto a2 { pdf_a * pdf_a };
+            return a2 / (a2 + pdf_b * pdf_b);
+        }
 
     public:
         World(
             const HittableList& world,
-            Colour background = Colour(1e-3, 1e-3, 1e-3)
+            Colour background = Colour(1e-3, 1e-3, 1e-3),
+            const HittableList& lights = HittableList {}
         ) : world_{ std::make_shared<HittableList>(world) },
-            background_{ background } {}
+            background_{ background },
+            lights_{ lights } {}
 
-        Colour ray_colour(
-            const Ray& r, int depth
+        const Colour& background() const { return background_; }
+
+        bool has_lights() const { return !lights_.objects.empty(); }
+
+        AABB bounding_box() const { return world_->bounding_box(); }
+
+        // Closest hit along r with full shading data. The texture footprint
+        // is that of the ray's cone where it meets the surface, so rays
+        // without a cone get point lookups.
+        bool intersect(
+            const Ray& r, HitRecord& rec, const RayCone& cone = {}
         ) const {
-            if (depth <= 0) return background_;
+            if (!world_->closest_hit(r, ray_t, rec)) return false;
+            if (cone.width > 0 || cone.spread > 0) {
+                rec.set_footprint(r, cone.at(hit_distance(r, rec)).width);
+            }
+            return true;
+        }
+
+        static double hit_distance(const Ray& r, const HitRecord& rec) {
+            return rec.t * r.direction().length();
+        }
 
-            HitRecord rec {};
+        // Emission seen at rec. When the previous vertex could have sampled
+        // the lights the emission is MIS weighted against that, otherwise
+        // (camera or specular rays) it is counted in full. Templated on the
+        // material so batched shading can call final classes directly.
+        template <typename M>
+        Colour emission(
+            const M& mat,
+            const Ray& r,
+            const HitRecord& rec,
+            bool specular,
+            double bsdf_pdf
+        ) const {
+            const auto emitted { mat.emitted(rec.u, rec.v, rec.p) };
+            if (specular || !has_lights()) return emitted;
+            if (emitted == Colour(0, 0, 0)) return emitted;
+            const auto light_pdf {
+                lights_.pdf_value(r.origin(), r.direction())
+            };
+            return emitted * power_heuristic(bsdf_pdf, light_pdf);
+        }
 
-            if (!world_->hit(r, IntervalD{0.001, infinity_d}, rec)) {
-                return background_;
+        // Next event estimation: direct light from one sampled point on the
+        // lights, weighted against the material's own sampling strategy
+        template <typename M>
+        Colour sample_lights(
+            const M& mat, const Ray& r_in, const HitRecord& rec
+        ) const {
+            const auto direction { lights_.random(rec.p) };
+            const auto light_pdf { lights_.pdf_value(rec.p, direction) };
+            if (light_pdf <= 0) return Colour(0, 0, 0);
+
+            const auto f { mat.eval(r_in, rec, direction) };
+            if (f == Colour(0, 0, 0)) return Colour(0, 0, 0);
+
+            // Find the light point on the (small) light list, then only ask
+            // the scene whether anything lies in between
+            HitRecord light_rec {};
+            const auto shadow { rec.spawn_ray(direction, r_in.time()) };
+            if (!lights_.closest_hit(shadow, ray_t, light_rec)) {
+                return Colour(0, 0, 0);
             }
+            const IntervalR unoccluded {
+                ray_t.min(), light_rec.t * (1 - shadow_epsilon)
+            };
+            const auto transmitted {
+                world_->transmittance(shadow, unoccluded)
+            };
+            if (transmitted <= 0) return Colour(0, 0, 0);
+
+            const auto emitted {
+                light_rec.mat->emitted(light_rec.u, light_rec.v, light_rec.p)
+            };
+            const auto bsdf_pdf { mat.pdf(r_in, rec, direction) };
+            return emitted * f * (transmitted
+                * (power_heuristic(light_pdf, bsdf_pdf) / light_pdf));
+        }
+
+        // Radiance along r_in. The cone follows the path, widening at its
+        // original spread; curvature at each bounce is ignored.
+        Colour ray_colour(
+            const Ray& r_in, int depth, RayCone cone = {}
+        ) const {
+            Colour radiance { 0, 0, 0 };
+            Colour throughput { 1, 1, 1 };
+            Ray r { r_in };
+            bool specular { true };
+            double bsdf_pdf { 0 };
+
+            for (; depth > 0; depth--) {
+                HitRecord rec {};
+
+                if (!intersect(r, rec, cone)) {
+                    return radiance + throughput * background_;
+                }
+                cone = cone.at(hit_distance(r, rec));
+
+                const auto& mat { *rec.mat };
+                radiance += throughput
+                    * emission(mat, r, rec, specular, bsdf_pdf);
+
+                ScatterRecord srec {};
+                if (!mat.sample(r, rec, srec)) {
+                    return radiance;
+                }
 
-            Ray scattered {};
-            Colour attenuation {};
-            Colour emitted { rec.mat->emitted(rec.u, rec.v, rec.p) };
+                if (!srec.is_specular && has_lights()) {
+                    radiance += throughput * sample_lights(mat, r, rec);
+                }
 
-            if (!rec.mat->scatter(r, rec, attenuation, scattered)) {
-                return emitted;
+                throughput = throughput * srec.attenuation;
+                specular = srec.is_specular;
+                bsdf_pdf = srec.pdf;
+                r = srec.scattered;
             }
 
-            return emitted
-                + attenuation * ray_colour(scattered, depth - 1);
+            return radiance + throughput * background_;
         }
 };
 